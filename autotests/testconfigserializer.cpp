@@ -19,6 +19,7 @@
 #include <QObject>
 #include <QtTest>
 
+#include "config.h"
 #include "configserializer_p.h"
 #include "mode.h"
 #include "output.h"
@@ -184,6 +185,46 @@ private Q_SLOTS:
 
         QCOMPARE(obj2[QStringLiteral("refresh")].toDouble(), output->commanded_mode()->refresh());
     }
+
+    void testDeserializeJson()
+    {
+        Disman::ModeMap modes;
+        Disman::ModePtr mode(new Disman::Mode);
+        mode->set_id("1");
+        mode->set_name("1920x1080");
+        mode->set_size(QSize(1920, 1080));
+        mode->set_refresh(60000);
+        modes.insert({mode->id(), mode});
+
+        Disman::OutputPtr output(new Disman::Output);
+        output->set_id(60);
+        output->set_name("DP-1");
+        output->setType(Disman::Output::DisplayPort);
+        output->set_modes(modes);
+        output->set_mode(mode);
+        output->set_position(QPoint(1280, 0));
+        output->set_preferred_modes({"1"});
+        output->set_enabled(true);
+        output->set_physical_size(QSize(520, 290));
+
+        Disman::ScreenPtr screen(new Disman::Screen);
+        screen->set_id(12);
+        screen->set_current_size(QSize(3200, 1080));
+        screen->set_max_size(QSize(8192, 8192));
+        screen->set_min_size(QSize(320, 200));
+        screen->set_max_outputs_count(4);
+
+        auto config = std::make_shared<Disman::Config>(Disman::Config::Cause::file);
+        config->set_outputs({{output->id(), output}});
+        config->set_primary_output(output);
+        config->setScreen(screen);
+
+        auto const obj = Disman::ConfigSerializer::serialize_config(config);
+        auto const deserialized = Disman::ConfigSerializer::deserialize_config(obj);
+        QVERIFY(deserialized);
+        QVERIFY(config->compare(deserialized));
+        QCOMPARE(deserialized->primary_output()->id(), 60);
+    }
 };
 
 QTEST_MAIN(TestConfigSerializer)
@@ -0,0 +1,188 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "config.h"
+#include "configserializer_p.h"
+#include "configsnapshot.h"
+#include "mode.h"
+#include "output.h"
+#include "screen.h"
+
+#include <QtTest>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Disman;
+
+class TestConfigSnapshot : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testNull();
+    void testRoundTrip();
+    void testCompare();
+    void testWorkerThreads();
+
+private:
+    ConfigPtr create_config() const;
+};
+
+ConfigPtr TestConfigSnapshot::create_config() const
+{
+    auto config = std::make_shared<Config>(Config::Cause::file);
+    config->set_generation(7);
+    config->set_supported_features(Config::Feature::Writable | Config::Feature::PrimaryDisplay);
+    config->set_tablet_mode_available(true);
+
+    auto screen = std::make_shared<Screen>();
+    screen->set_id(1);
+    screen->set_current_size(QSize(3840, 1080));
+    screen->set_max_size(QSize(8192, 8192));
+    screen->set_max_outputs_count(2);
+    config->setScreen(screen);
+
+    for (int id : {2, 1}) {
+        auto output = std::make_shared<Output>();
+        output->set_id(id);
+        output->set_name("DP-" + std::to_string(id));
+        output->set_hash_raw("hash-" + std::to_string(id));
+
+        ModeMap modes;
+        for (int refresh : {60000, 144000}) {
+            auto mode = std::make_shared<Mode>();
+            mode->set_id(std::to_string(refresh));
+            mode->set_size(QSize(1920, 1080));
+            mode->set_refresh(refresh);
+            modes.insert({mode->id(), mode});
+        }
+        output->set_modes(modes);
+        output->set_preferred_modes({"144000"});
+        output->set_mode(output->mode("144000"));
+
+        output->set_enabled(true);
+        output->set_position(QPointF((id - 1) * 1920, 0));
+        output->set_scale(1.25);
+        output->set_rotation(Output::Left);
+        output->set_retention(Output::Retention::Individual);
+        if (id == 1) {
+            output->force_geometry(QRectF(0, 0, 1536, 864));
+        }
+        config->add_output(output);
+
+        if (id == 2) {
+            config->set_primary_output(output);
+        }
+    }
+
+    return config;
+}
+
+void TestConfigSnapshot::testNull()
+{
+    ConfigSnapshot snapshot;
+    QVERIFY(snapshot.is_null());
+    QVERIFY(!snapshot.to_config());
+    QVERIFY(snapshot.outputs().empty());
+    QVERIFY(!snapshot.output(1));
+    QVERIFY(!snapshot.screen());
+
+    QVERIFY(ConfigSnapshot(ConfigPtr()).is_null());
+    QVERIFY(snapshot.compare(ConfigSnapshot()));
+    QVERIFY(!snapshot.compare(ConfigSnapshot(create_config())));
+}
+
+void TestConfigSnapshot::testRoundTrip()
+{
+    auto const config = create_config();
+    ConfigSnapshot const snapshot(config);
+
+    QVERIFY(!snapshot.is_null());
+    QCOMPARE(snapshot.cause(), Config::Cause::file);
+    QCOMPARE(snapshot.generation(), uint64_t(7));
+    QCOMPARE(snapshot.supported_features(), config->supported_features());
+    QVERIFY(snapshot.tablet_mode_available());
+    QVERIFY(!snapshot.tablet_mode_engaged());
+    QCOMPARE(snapshot.hash(), config->hash());
+    QCOMPARE(snapshot.primary_output_id(), 2);
+
+    QVERIFY(snapshot.screen());
+    QCOMPARE(snapshot.screen()->current_size, QSize(3840, 1080));
+    QCOMPARE(snapshot.screen()->max_outputs_count, 2);
+
+    QCOMPARE(snapshot.outputs().size(), size_t(2));
+    QCOMPARE(snapshot.outputs().front().id, 1);
+
+    auto const output = snapshot.output(2);
+    QVERIFY(output);
+    QCOMPARE(output->name, std::string("DP-2"));
+    QCOMPARE(output->modes.size(), size_t(2));
+    QCOMPARE(output->refresh_rate, 144000);
+    QCOMPARE(output->position, QPointF(1920, 0));
+    QCOMPARE(output->rotation, Output::Left);
+    QCOMPARE(output->retention, Output::Retention::Individual);
+    QVERIFY(!output->enforced_geometry.isValid());
+    QCOMPARE(snapshot.output(1)->enforced_geometry, QRectF(0, 0, 1536, 864));
+
+    auto const restored = snapshot.to_config();
+    QVERIFY(restored);
+    QVERIFY(restored != config);
+    QVERIFY(restored->compare(config));
+    QCOMPARE(restored->primary_output()->id(), 2);
+    QCOMPARE(restored->output(1)->commanded_mode()->refresh(), 144000);
+    QCOMPARE(restored->output(1)->geometry(), QRectF(0, 0, 1536, 864));
+
+    // Later changes to the config do not reach the snapshot.
+    config->output(1)->set_enabled(false);
+    QVERIFY(snapshot.output(1)->enabled);
+    QVERIFY(!snapshot.compare(ConfigSnapshot(config)));
+}
+
+void TestConfigSnapshot::testCompare()
+{
+    ConfigSnapshot const snapshot(create_config());
+    auto const copy = snapshot;
+    QVERIFY(snapshot.compare(copy));
+    QVERIFY(snapshot.compare(ConfigSnapshot(create_config())));
+
+    auto config = create_config();
+    config->output(2)->set_scale(2.);
+    QVERIFY(!snapshot.compare(ConfigSnapshot(config)));
+
+    config = create_config();
+    config->remove_output(1);
+    QVERIFY(!snapshot.compare(ConfigSnapshot(config)));
+}
+
+void TestConfigSnapshot::testWorkerThreads()
+{
+    ConfigSnapshot const snapshot(create_config());
+    auto const expected = ConfigSerializer::serialize_config(snapshot);
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; i++) {
+        workers.emplace_back([snapshot, expected, &failures] {
+            for (int j = 0; j < 50; j++) {
+                auto const config = snapshot.to_config();
+                if (!ConfigSnapshot(config).compare(snapshot)
+                    || ConfigSerializer::serialize_config(snapshot) != expected) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    QCOMPARE(failures.load(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestConfigSnapshot)
+
+#include "testconfigsnapshot.moc"
@@ -0,0 +1,292 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "control_store.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QtTest>
+
+using namespace Disman;
+
+class TestControlStore : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void testSaveAndLoad();
+    void testMoveConfig();
+    void testSync();
+    void testMigration();
+    void testIndexMigration();
+    void testCompact();
+    void testWarmUpCompacts();
+    void testSaveAppendsChanges();
+
+private:
+    QVariantMap config_info(QStringList const& output_hashes) const;
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+void TestControlStore::init()
+{
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+}
+
+QVariantMap TestControlStore::config_info(QStringList const& output_hashes) const
+{
+    QVariantList outputs;
+    for (auto const& hash : output_hashes) {
+        QVariantMap output;
+        output[QStringLiteral("id")] = hash;
+        output[QStringLiteral("enabled")] = true;
+        outputs << output;
+    }
+
+    QVariantMap info;
+    info[QStringLiteral("outputs")] = outputs;
+    return info;
+}
+
+void TestControlStore::testSaveAndLoad()
+{
+    auto const info = config_info({QStringLiteral("a"), QStringLiteral("b")});
+    QVariantMap output_info;
+    output_info[QStringLiteral("scale")] = 2.;
+
+    {
+        Control_store store(m_dir->path());
+        QVERIFY(!store.has_config("ab"));
+
+        store.set_config_info("ab", info);
+        store.set_output_info("a", output_info);
+        QVERIFY(store.has_config("ab"));
+        QVERIFY(store.save());
+    }
+
+    Control_store store(m_dir->path());
+    QVERIFY(store.has_config("ab"));
+    QCOMPARE(store.config_info("ab"), info);
+    QCOMPARE(store.output_info("a"), output_info);
+    QVERIFY(store.output_info("b").isEmpty());
+
+    // An empty record removes it.
+    store.set_config_info("ab", QVariantMap());
+    QVERIFY(!store.has_config("ab"));
+}
+
+void TestControlStore::testMoveConfig()
+{
+    Control_store store(m_dir->path());
+    auto const info = config_info({QStringLiteral("a")});
+
+    QVERIFY(!store.move_config("a-open-lid", "a"));
+
+    store.set_config_info("a-open-lid", info);
+    QVERIFY(store.move_config("a-open-lid", "a"));
+    QVERIFY(!store.has_config("a-open-lid"));
+    QCOMPARE(store.config_info("a"), info);
+}
+
+void TestControlStore::testSync()
+{
+    Control_store store(m_dir->path());
+    store.set_config_info("a", config_info({QStringLiteral("a")}));
+    QVERIFY(store.save());
+
+    // Another process writes the store.
+    {
+        Control_store other(m_dir->path());
+        other.set_config_info("b", config_info({QStringLiteral("b")}));
+
+        // Make sure the modification time differs from the first save.
+        QTest::qWait(10);
+        QVERIFY(other.save());
+    }
+
+    QVERIFY(!store.has_config("b"));
+    store.sync();
+    QVERIFY(store.has_config("a"));
+    QVERIFY(store.has_config("b"));
+}
+
+void TestControlStore::testMigration()
+{
+    QDir dir(m_dir->path());
+    QVERIFY(dir.mkpath(QStringLiteral("configs")));
+    QVERIFY(dir.mkpath(QStringLiteral("outputs")));
+
+    auto write_legacy = [&dir](QString const& path, QVariantMap const& info) {
+        QFile file(dir.filePath(path));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QJsonDocument::fromVariant(info).toJson());
+    };
+
+    auto const info = config_info({QStringLiteral("out1")});
+    QVariantMap output_info;
+    output_info[QStringLiteral("rotation")] = 2;
+
+    write_legacy(QStringLiteral("configs/cfg.json"), info);
+    write_legacy(QStringLiteral("configs/cfg-open-lid.json"), info);
+    write_legacy(QStringLiteral("outputs/out1.json"), output_info);
+
+    Control_store store(m_dir->path());
+    QCOMPARE(store.config_info("cfg"), info);
+    QCOMPARE(store.config_info("cfg-open-lid"), info);
+    QCOMPARE(store.output_info("out1"), output_info);
+
+    QVERIFY(QFile::exists(store.file_path()));
+    QVERIFY(!dir.exists(QStringLiteral("configs")));
+    QVERIFY(!dir.exists(QStringLiteral("outputs")));
+}
+
+void TestControlStore::testIndexMigration()
+{
+    auto const info = config_info({QStringLiteral("out1")});
+    QVariantMap output_info;
+    output_info[QStringLiteral("rotation")] = 2;
+
+    // Earlier stores held all records in the index file.
+    QVariantMap config;
+    config[QStringLiteral("info")] = info;
+    config[QStringLiteral("last-write")] = 1;
+
+    QVariantMap configs;
+    configs[QStringLiteral("cfg")] = config;
+    QVariantMap outputs;
+    outputs[QStringLiteral("out1")] = output_info;
+
+    QVariantMap old_store;
+    old_store[QStringLiteral("configs")] = configs;
+    old_store[QStringLiteral("outputs")] = outputs;
+
+    {
+        QFile file(QDir(m_dir->path()).filePath(QStringLiteral("store.json")));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QJsonDocument::fromVariant(old_store).toJson());
+    }
+
+    {
+        Control_store store(m_dir->path());
+        QCOMPARE(store.config_info("cfg"), info);
+        QCOMPARE(store.output_info("out1"), output_info);
+    }
+
+    QFile file(QDir(m_dir->path()).filePath(QStringLiteral("store.json")));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(QJsonDocument::fromJson(file.readAll())[QLatin1String("version")].toInt(), 2);
+
+    Control_store store(m_dir->path());
+    QCOMPARE(store.config_info("cfg"), info);
+    QCOMPARE(store.output_info("out1"), output_info);
+}
+
+void TestControlStore::testCompact()
+{
+    Control_store store(m_dir->path());
+
+    QVariantMap output_info;
+    output_info[QStringLiteral("scale")] = 1.5;
+
+    store.set_config_info("a", config_info({QStringLiteral("a")}));
+    store.set_config_info("b", config_info({QStringLiteral("b")}));
+    store.set_output_info("a", output_info);
+    store.set_output_info("b", output_info);
+    store.set_output_info("stale", output_info);
+
+    QCOMPARE(store.compact(), 1);
+    QVERIFY(store.output_info("stale").isEmpty());
+    QVERIFY(!store.output_info("a").isEmpty());
+
+    // With a limit of one config the least recently written one and its output go.
+    QCOMPARE(store.compact(1), 2);
+    QVERIFY(!store.has_config("a"));
+    QVERIFY(store.has_config("b"));
+    QVERIFY(store.output_info("a").isEmpty());
+}
+
+void TestControlStore::testWarmUpCompacts()
+{
+    QVariantMap output_info;
+    output_info[QStringLiteral("scale")] = 1.5;
+
+    {
+        Control_store store(m_dir->path());
+        store.set_config_info("a", config_info({QStringLiteral("a")}));
+        store.set_output_info("a", output_info);
+
+        auto stale_info = output_info;
+        stale_info[QStringLiteral("name")] = QStringLiteral("stale");
+        store.set_output_info("stale", stale_info);
+        QVERIFY(store.save());
+    }
+
+    // The warm-up on construction compacts and writes back without any further call.
+    {
+        Control_store store(m_dir->path());
+        QVERIFY(store.has_config("a"));
+        QVERIFY(store.output_info("stale").isEmpty());
+    }
+
+    // Neither the index nor the data file keeps the removed record.
+    auto const files = QDir(m_dir->path()).entryInfoList(QDir::Files);
+    QVERIFY(!files.isEmpty());
+    for (auto const& file_info : files) {
+        QFile file(file_info.filePath());
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(!file.readAll().contains("stale"));
+    }
+}
+
+void TestControlStore::testSaveAppendsChanges()
+{
+    QVariantMap output_info;
+    output_info[QStringLiteral("scale")] = 1.5;
+
+    Control_store store(m_dir->path());
+    store.set_config_info("a", config_info({QStringLiteral("a")}));
+    store.set_config_info("b", config_info({QStringLiteral("b")}));
+    store.set_output_info("a", output_info);
+    store.set_output_info("b", output_info);
+    QVERIFY(store.save());
+
+    auto data_files = [this] {
+        return QDir(m_dir->path()).entryInfoList({QStringLiteral("*.data")}, QDir::Files);
+    };
+    QCOMPARE(data_files().size(), 1);
+    auto const size = data_files().at(0).size();
+
+    // Saving without changes writes no records.
+    QVERIFY(store.save());
+    QCOMPARE(data_files().at(0).size(), size);
+
+    // Only the changed record is appended.
+    output_info[QStringLiteral("scale")] = 2.;
+    store.set_output_info("b", output_info);
+    QVERIFY(store.save());
+
+    auto const record_size
+        = QJsonDocument(QJsonObject::fromVariantMap(output_info)).toJson(QJsonDocument::Compact)
+              .size()
+        + 1;
+    QCOMPARE(data_files().size(), 1);
+    QCOMPARE(data_files().at(0).size(), size + record_size);
+
+    Control_store loaded(m_dir->path());
+    QCOMPARE(loaded.output_info("b"), output_info);
+    QCOMPARE(loaded.config_info("a"), config_info({QStringLiteral("a")}));
+}
+
+QTEST_GUILESS_MAIN(TestControlStore)
+
+#include "testcontrolstore.moc"
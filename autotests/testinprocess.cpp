@@ -18,7 +18,11 @@
 #include <QCoreApplication>
 #include <QDBusConnectionInterface>
 #include <QObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QtTest>
 
 #include "backendmanager_p.h"
@@ -29,6 +33,8 @@
 #include "output.h"
 #include "setconfigoperation.h"
 
+#include <algorithm>
+
 Q_LOGGING_CATEGORY(DISMAN, "disman")
 
 using namespace Disman;
@@ -51,9 +57,15 @@ private Q_SLOTS:
     void testCreateJob();
     void testModeSwitching();
     void testBackendCaching();
+    void testCachedConfig();
 
     void testConfigApply();
     void testConfigMonitor();
+    void testSetConfigCoalescing();
+    void testConcurrentWriters();
+    void testFakeFileReload();
+    void testAsyncInit();
+    void testMethodChangeWhilePending();
 
 private:
     ConfigPtr m_config;
@@ -252,6 +264,39 @@ void TestInProcess::testBackendCaching()
     }
 }
 
+void TestInProcess::testCachedConfig()
+{
+    if (!m_backendServiceInstalled) {
+        QSKIP("Backend service not installed");
+    }
+
+    qputenv("DISMAN_BACKEND", "fake");
+    qputenv("DISMAN_IN_PROCESS", "0");
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::OutOfProcess);
+
+    // Nothing cached yet, so the first operation needs to ask the backend.
+    auto cold_op = new GetConfigOperation(GetConfigOperation::Option::Cached);
+    QVERIFY(cold_op->exec());
+    QVERIFY(!cold_op->cached());
+    auto cold_config = cold_op->config();
+    QVERIFY(cold_config);
+
+    auto warm_op = new GetConfigOperation(GetConfigOperation::Option::Cached);
+    QVERIFY(warm_op->exec());
+    QVERIFY(warm_op->cached());
+    auto warm_config = warm_op->config();
+    QVERIFY(warm_config);
+    QVERIFY(warm_config->compare(cold_config));
+    QVERIFY(warm_config->generation() > 0);
+
+    // Cached configs are copies.
+    QVERIFY(warm_config != BackendManager::instance()->config());
+
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+}
+
 void TestInProcess::testCreateJob()
 {
     Disman::BackendManager::instance()->shutdown_backend();
@@ -334,6 +379,209 @@ void TestInProcess::testConfigMonitor()
     QVERIFY(monitorSpy.wait(500));
 }
 
+void TestInProcess::testSetConfigCoalescing()
+{
+    if (!m_backendServiceInstalled) {
+        QSKIP("Backend service not installed");
+    }
+
+    qputenv("DISMAN_BACKEND", "fake");
+    qputenv("DISMAN_IN_PROCESS", "0");
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::OutOfProcess);
+
+    auto op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    auto config = op->config();
+    QVERIFY(config);
+
+    std::vector<SetConfigOperation*> set_ops;
+    std::vector<bool> superseded;
+
+    for (int i = 0; i < 3; i++) {
+        auto set_op = new SetConfigOperation(config->clone());
+        connect(set_op, &SetConfigOperation::finished, this, [&](ConfigOperation* op) {
+            auto finished_op = qobject_cast<SetConfigOperation*>(op);
+            QVERIFY(finished_op->config());
+            superseded.push_back(finished_op->superseded());
+        });
+        set_ops.push_back(set_op);
+    }
+
+    // The first one is sent right away, the second one is replaced by the third one.
+    QVERIFY(set_ops.at(2)->exec());
+    QVERIFY(!set_ops.at(2)->superseded());
+
+    QCOMPARE(static_cast<int>(superseded.size()), 3);
+    QCOMPARE(static_cast<int>(std::count(superseded.cbegin(), superseded.cend(), true)), 1);
+
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+}
+
+void TestInProcess::testConcurrentWriters()
+{
+    if (!m_backendServiceInstalled) {
+        QSKIP("Backend service not installed");
+    }
+
+    qputenv("DISMAN_BACKEND", "fake");
+    qputenv("DISMAN_IN_PROCESS", "0");
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::OutOfProcess);
+
+    auto op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    auto const config = op->config();
+    QVERIFY(config);
+    QVERIFY(config->generation() > 0);
+
+    // Two clients change different outputs of the same config.
+    auto first = config->clone();
+    first->output(1)->set_scale(2.);
+    auto second = config->clone();
+    second->output(2)->set_position(QPointF(5000, 0));
+
+    auto first_op = new SetConfigOperation(first);
+    QVERIFY(first_op->exec());
+    QVERIFY(first_op->config()->generation() > config->generation());
+
+    // The second one is outdated now. Its change is applied on top of the first one.
+    auto second_op = new SetConfigOperation(second);
+    QVERIFY(second_op->exec());
+    auto const result = second_op->config();
+    QVERIFY(result);
+    QCOMPARE(result->output(1)->scale(), 2.);
+    QCOMPARE(result->output(2)->position(), QPointF(5000, 0));
+
+    // Setting the outdated config once more changes nothing.
+    auto repeat_op = new SetConfigOperation(second->clone());
+    QVERIFY(repeat_op->exec());
+    QCOMPARE(repeat_op->config()->generation(), result->generation());
+
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+}
+
+void TestInProcess::testFakeFileReload()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    auto const path = dir.filePath(QStringLiteral("config.json"));
+    QVERIFY(QFile::copy(QStringLiteral(TEST_DATA "multipleoutput.json"), path));
+    QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner);
+
+    qputenv("DISMAN_BACKEND_ARGS", QByteArray("TEST_DATA=") + path.toUtf8());
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+
+    auto op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    auto config = op->config();
+    QCOMPARE(config->outputs().size(), 2);
+
+    QSignalSpy monitorSpy(ConfigMonitor::instance(), &ConfigMonitor::configuration_changed);
+    ConfigMonitor::instance()->add_config(config);
+
+    // Drop the second output from the file, the backend must pick up the change on its own.
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    auto json = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+
+    auto outputs = json[QStringLiteral("outputs")].toArray();
+    outputs.removeLast();
+    json[QStringLiteral("outputs")] = outputs;
+
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(QJsonDocument(json).toJson());
+    file.close();
+
+    QVERIFY(monitorSpy.wait(2000));
+    QCOMPARE(config->outputs().size(), 1);
+
+    Disman::BackendManager::instance()->shutdown_backend();
+}
+
+void TestInProcess::testAsyncInit()
+{
+    qputenv("DISMAN_BACKEND_ARGS", "TEST_DATA=" TEST_DATA "multipleoutput.json;INIT_DELAY=100");
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+
+    // Operations wait for the backend to finish its initialization.
+    auto op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    auto config = op->config();
+    QVERIFY(config);
+    QCOMPARE(config->outputs().size(), 2);
+
+    auto set_op = new SetConfigOperation(config);
+    QVERIFY(set_op->exec());
+
+    // With a failed initialization they finish with an error.
+    qputenv("DISMAN_BACKEND_ARGS",
+            "TEST_DATA=" TEST_DATA "multipleoutput.json;INIT_DELAY=100;INIT_FAIL=1");
+    Disman::BackendManager::instance()->shutdown_backend();
+
+    op = new GetConfigOperation();
+    QVERIFY(!op->exec());
+}
+
+void TestInProcess::testMethodChangeWhilePending()
+{
+    if (!m_backendServiceInstalled) {
+        QSKIP("Backend service not installed");
+    }
+
+    qputenv("DISMAN_BACKEND", "fake");
+    qputenv("DISMAN_IN_PROCESS", "0");
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::OutOfProcess);
+
+    auto op = new GetConfigOperation();
+    QVERIFY(op->exec());
+
+    // The next operation requests the backend and waits for it to be handed out.
+    auto pending_op = new GetConfigOperation();
+    QSignalSpy spy(pending_op, &GetConfigOperation::finished);
+    QVERIFY(spy.isValid());
+
+    // The operation deletes itself after finishing.
+    bool failed = false;
+    connect(pending_op, &GetConfigOperation::finished, this, [&failed](ConfigOperation* op) {
+        failed = op->has_error();
+    });
+    QCoreApplication::processEvents();
+
+    // The pending request fails instead of reaching the operation after the change.
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+    QVERIFY(spy.count() == 1 || spy.wait(1000));
+    QVERIFY(failed);
+
+    // Late answers of the service are ignored.
+    QTest::qWait(200);
+
+    op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    QVERIFY(op->config());
+
+    // A request right after a shutdown waits for the old service to leave the bus.
+    BackendManager::instance()->set_method(BackendManager::OutOfProcess);
+    op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    Disman::BackendManager::instance()->shutdown_backend();
+
+    op = new GetConfigOperation();
+    QVERIFY(op->exec());
+    QVERIFY(op->config());
+
+    Disman::BackendManager::instance()->shutdown_backend();
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+}
+
 QTEST_GUILESS_MAIN(TestInProcess)
 
 #include "testinprocess.moc"
@@ -0,0 +1,146 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "lid_switch.h"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <fcntl.h>
+#include <linux/input.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Disman;
+
+class TestLidSwitch : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testEvents();
+    void testDroppedEvents();
+    void testLost();
+    void testMissingDevice();
+
+private:
+    void send(uint16_t type, uint16_t code, int32_t value);
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+    QString m_path;
+    int m_fd{-1};
+};
+
+void TestLidSwitch::init()
+{
+    // A pipe stands in for the input device node.
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+    m_path = m_dir->filePath(QStringLiteral("event0"));
+    QCOMPARE(mkfifo(QFile::encodeName(m_path).constData(), 0600), 0);
+
+    // Opened for reading too, so the switch never reads the end of the file.
+    m_fd = open(QFile::encodeName(m_path).constData(), O_RDWR | O_NONBLOCK);
+    QVERIFY(m_fd >= 0);
+}
+
+void TestLidSwitch::cleanup()
+{
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+void TestLidSwitch::send(uint16_t type, uint16_t code, int32_t value)
+{
+    input_event event{};
+    event.type = type;
+    event.code = code;
+    event.value = value;
+    QCOMPARE(write(m_fd, &event, sizeof(event)), static_cast<ssize_t>(sizeof(event)));
+}
+
+void TestLidSwitch::testEvents()
+{
+    Lid_switch lid_switch(m_path);
+    QVERIFY(lid_switch.valid());
+    QVERIFY(!lid_switch.closed());
+
+    QSignalSpy spy(&lid_switch, &Lid_switch::closed_changed);
+    QVERIFY(spy.isValid());
+
+    send(EV_SW, SW_LID, 1);
+    send(EV_SYN, SYN_REPORT, 0);
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.last().at(0).toBool(), true);
+    QVERIFY(lid_switch.closed());
+
+    // Other switches and repeated states are ignored.
+    send(EV_SW, SW_TABLET_MODE, 1);
+    send(EV_SW, SW_LID, 1);
+    send(EV_SW, SW_LID, 0);
+    send(EV_SYN, SYN_REPORT, 0);
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.last().at(0).toBool(), false);
+    QVERIFY(!lid_switch.closed());
+}
+
+void TestLidSwitch::testDroppedEvents()
+{
+    Lid_switch lid_switch(m_path);
+    QVERIFY(lid_switch.valid());
+
+    QSignalSpy spy(&lid_switch, &Lid_switch::closed_changed);
+    QVERIFY(spy.isValid());
+
+    // Events up to the next report after a drop are incomplete and ignored. A pipe has no state to
+    // query instead, so the state stays as it was.
+    send(EV_SYN, SYN_DROPPED, 0);
+    send(EV_SW, SW_LID, 1);
+    send(EV_SYN, SYN_REPORT, 0);
+    send(EV_SW, SW_LID, 0);
+    send(EV_SYN, SYN_REPORT, 0);
+    QVERIFY(!spy.wait(100));
+    QVERIFY(!lid_switch.closed());
+
+    send(EV_SW, SW_LID, 1);
+    send(EV_SYN, SYN_REPORT, 0);
+    QVERIFY(spy.wait());
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(lid_switch.closed());
+}
+
+void TestLidSwitch::testLost()
+{
+    Lid_switch lid_switch(m_path);
+    QVERIFY(lid_switch.valid());
+
+    QSignalSpy spy(&lid_switch, &Lid_switch::lost);
+    QVERIFY(spy.isValid());
+
+    // Without a writer the switch reads the end of the file.
+    close(m_fd);
+    m_fd = -1;
+    QVERIFY(spy.wait());
+    QVERIFY(!lid_switch.valid());
+}
+
+void TestLidSwitch::testMissingDevice()
+{
+    Lid_switch lid_switch(m_dir->filePath(QStringLiteral("event1")));
+    QVERIFY(!lid_switch.valid());
+}
+
+QTEST_GUILESS_MAIN(TestLidSwitch)
+
+#include "testlidswitch.moc"
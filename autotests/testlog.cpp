@@ -19,7 +19,9 @@
 #include <QObject>
 #include <QtTest>
 
+#include "config.h"
 #include "log.h"
+#include "screen.h"
 
 Q_DECLARE_LOGGING_CATEGORY(DISMAN_TESTLOG)
 
@@ -40,6 +42,7 @@ private Q_SLOTS:
     void testContext();
     void testEnabled();
     void testLog();
+    void testLogConfig();
 
 private:
     QString m_defaultLogFile;
@@ -102,7 +105,6 @@ void TestLog::testEnabled()
 void TestLog::testLog()
 {
     auto log = Log::instance();
-    Q_UNUSED(log);
 
     QFile lf(m_defaultLogFile);
     lf.remove();
@@ -111,14 +113,25 @@ void TestLog::testLog()
     QString logmsg = QStringLiteral("This is a log message. ♥");
     Log::log(logmsg);
 
+    // Messages are written asynchronously.
+    log->flush();
     QVERIFY(lf.exists());
+    QVERIFY(lf.open(QIODevice::ReadOnly | QIODevice::Text));
+    QVERIFY(QString::fromUtf8(lf.readAll()).contains(logmsg));
+    lf.close();
     QVERIFY(lf.remove());
 
     qCDebug(DISMAN_TESTLOG) << "qCDebug message from testlog";
+    log->flush();
     QVERIFY(lf.exists());
     QVERIFY(lf.remove());
 
+    // Destroying the log writes pending messages too.
+    Log::log(logmsg);
+
     delete Log::instance();
+    QVERIFY(lf.exists());
+    QVERIFY(lf.remove());
 
     // Make sure on log file gets written when disabled
     qputenv(DISMAN_LOGGING, "false");
@@ -128,6 +141,7 @@ void TestLog::testLog()
     QVERIFY(!lf.exists());
 
     Log::log(logmsg);
+    Log::instance()->flush();
     QVERIFY(!lf.exists());
 
     // Make sure we don't crash on cleanup
@@ -135,6 +149,41 @@ void TestLog::testLog()
     delete Log::instance();
 }
 
+void TestLog::testLogConfig()
+{
+    qputenv(DISMAN_LOGGING, "true");
+    auto log = Log::instance();
+    QVERIFY(log->enabled());
+
+    QFile lf(m_defaultLogFile);
+    lf.remove();
+
+    auto config = std::make_shared<Config>();
+    config->setScreen(std::make_shared<Screen>());
+
+    DISMAN_LOG_CONFIG(DISMAN_TESTLOG, QStringLiteral("First:"), config);
+    DISMAN_LOG_CONFIG(DISMAN_TESTLOG, QStringLiteral("Second:"), config);
+
+    // A config changed after logging it must not influence the logged snapshot.
+    config->set_tablet_mode_available(true);
+    DISMAN_LOG_CONFIG(DISMAN_TESTLOG, QStringLiteral("Third:"), config);
+    config->set_tablet_mode_engaged(true);
+
+    log->flush();
+    QVERIFY(lf.open(QIODevice::ReadOnly | QIODevice::Text));
+    auto const content = QString::fromUtf8(lf.readAll());
+    lf.close();
+
+    QVERIFY(content.contains(QStringLiteral("First: [config #1]")));
+    QVERIFY(content.contains(QStringLiteral("Second: [config #1, unchanged]")));
+    QVERIFY(content.contains(QStringLiteral("Third: [config #2]")));
+    QVERIFY(content.contains(QStringLiteral("tablet-mode: disengaged")));
+    QVERIFY(!content.contains(QStringLiteral("tablet-mode: engaged")));
+
+    QVERIFY(lf.remove());
+    delete Log::instance();
+}
+
 QTEST_MAIN(TestLog)
 
 #include "testlog.moc"
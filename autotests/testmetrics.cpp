@@ -0,0 +1,116 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include <QtTest>
+
+#include "metrics.h"
+
+#include <chrono>
+
+using namespace Disman;
+using namespace std::chrono_literals;
+
+class TestMetrics : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testCounters();
+    void testBuckets();
+    void testPercentiles();
+    void testEmpty();
+
+private:
+    QVariantMap histogram(QString const& name) const;
+};
+
+QVariantMap TestMetrics::histogram(QString const& name) const
+{
+    auto const histograms = Metrics::snapshot().value(QStringLiteral("histograms")).toMap();
+    return histograms.value(name).toMap();
+}
+
+void TestMetrics::testCounters()
+{
+    Metrics::count(QStringLiteral("test-counter"));
+    Metrics::count(QStringLiteral("test-counter"), 41);
+
+    auto const counters = Metrics::snapshot().value(QStringLiteral("counters")).toMap();
+    QCOMPARE(counters.value(QStringLiteral("test-counter")).toULongLong(), qulonglong(42));
+}
+
+void TestMetrics::testBuckets()
+{
+    auto const name = QStringLiteral("test-buckets");
+
+    // The n-th bucket holds durations up to 2^n µs.
+    Metrics::record(name, 0us);
+    Metrics::record(name, 1us);
+    Metrics::record(name, 2us);
+    Metrics::record(name, 3us);
+    Metrics::record(name, 4us);
+    Metrics::record(name, 5us);
+    Metrics::record(name, 1000us);
+    Metrics::record(name, 20s);
+
+    // Negative durations count as zero.
+    Metrics::record(name, -5us);
+
+    auto const hist = histogram(name);
+    QCOMPARE(hist.value(QStringLiteral("count")).toULongLong(), qulonglong(9));
+    QCOMPARE(hist.value(QStringLiteral("sum-us")).toULongLong(), qulonglong(20001015));
+    QCOMPARE(hist.value(QStringLiteral("max-us")).toULongLong(), qulonglong(20000000));
+
+    auto const buckets = hist.value(QStringLiteral("buckets")).toList();
+    QCOMPARE(buckets.size(), 25);
+
+    auto bucket = [&buckets](int index) { return buckets.at(index).toULongLong(); };
+    QCOMPARE(bucket(0), qulonglong(3));
+    QCOMPARE(bucket(1), qulonglong(1));
+    QCOMPARE(bucket(2), qulonglong(2));
+    QCOMPARE(bucket(3), qulonglong(1));
+    QCOMPARE(bucket(10), qulonglong(1));
+
+    // Longer than 2^24 µs goes into the last bucket.
+    QCOMPARE(bucket(24), qulonglong(1));
+}
+
+void TestMetrics::testPercentiles()
+{
+    auto const name = QStringLiteral("test-percentiles");
+
+    for (int i = 0; i < 98; i++) {
+        Metrics::record(name, 100us);
+    }
+    Metrics::record(name, 3ms);
+    Metrics::record(name, 30s);
+
+    auto const hist = histogram(name);
+
+    // 100 µs is in the bucket up to 128 µs.
+    QCOMPARE(Metrics::percentile_us(hist, 0.5), uint64_t(128));
+    QCOMPARE(Metrics::percentile_us(hist, 0.98), uint64_t(128));
+
+    // 3 ms is in the bucket up to 4096 µs.
+    QCOMPARE(Metrics::percentile_us(hist, 0.99), uint64_t(4096));
+
+    // The last bucket has no upper bound.
+    QCOMPARE(Metrics::percentile_us(hist, 1.), uint64_t(30000000));
+
+    // A bound is never larger than the maximum.
+    auto const single = QStringLiteral("test-percentiles-single");
+    Metrics::record(single, 100us);
+    QCOMPARE(Metrics::percentile_us(histogram(single), 0.5), uint64_t(100));
+}
+
+void TestMetrics::testEmpty()
+{
+    QCOMPARE(Metrics::percentile_us(QVariantMap(), 0.5), uint64_t(0));
+    QVERIFY(histogram(QStringLiteral("test-never-recorded")).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestMetrics)
+
+#include "testmetrics.moc"
@@ -0,0 +1,161 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "backend.h"
+#include "backendmanager_p.h"
+#include "config.h"
+#include "metrics.h"
+#include "recording.h"
+#include "synthetic.h"
+
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+using namespace Disman;
+
+static ConfigPtr system_state(int outputs)
+{
+    // The windowing system does not know about the cause.
+    auto config = synthetic_config(outputs, 3);
+    config->set_cause(Config::Cause::unknown);
+    return config;
+}
+
+class TestReplay : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testReadRecording();
+    void testReplayDockFlapping();
+    void testReplayPreparedUnplug();
+
+private:
+    /// A laptop that is docked and undocked twice.
+    QString record_dock_flapping();
+
+    QTemporaryDir m_dir;
+};
+
+void TestReplay::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+
+    qputenv("DISMAN_LOGGING", "false");
+    qputenv("DISMAN_IN_PROCESS", "1");
+    qputenv("DISMAN_BACKEND", "replay");
+}
+
+void TestReplay::cleanup()
+{
+    BackendManager::instance()->shutdown_backend();
+}
+
+QString TestReplay::record_dock_flapping()
+{
+    auto const path = m_dir.filePath(QStringLiteral("dock-flapping.rec"));
+
+    Recording::Recorder recorder(path);
+    recorder.record(Recording::Event_type::initial, system_state(1));
+    recorder.record(Recording::Event_type::change, system_state(2));
+    recorder.record(Recording::Event_type::change, system_state(1));
+    recorder.record(Recording::Event_type::change, system_state(2));
+
+    return path;
+}
+
+void TestReplay::testReadRecording()
+{
+    auto const path = m_dir.filePath(QStringLiteral("read.rec"));
+    auto const config = synthetic_config(2, 3);
+
+    {
+        Recording::Recorder recorder(path);
+        QVERIFY(recorder.valid());
+        recorder.record(Recording::Event_type::initial, config);
+        recorder.record(Recording::Event_type::set, config, true);
+        recorder.record(Recording::Event_type::emitted, config);
+    }
+
+    auto const events = Recording::read(path);
+    QCOMPARE(events.size(), 3);
+
+    QCOMPARE(events.at(0).type, Recording::Event_type::initial);
+    QCOMPARE(events.at(1).type, Recording::Event_type::set);
+    QCOMPARE(events.at(2).type, Recording::Event_type::emitted);
+
+    QVERIFY(events.at(1).applied);
+    QVERIFY(!events.at(2).applied);
+    QVERIFY(events.at(0).time <= events.at(1).time);
+    QVERIFY(events.at(1).time <= events.at(2).time);
+
+    for (auto const& event : events) {
+        QVERIFY(config->compare(event.config));
+    }
+}
+
+void TestReplay::testReplayDockFlapping()
+{
+    auto const path = record_dock_flapping();
+    qputenv("DISMAN_BACKEND_ARGS", QByteArray("RECORDING=") + path.toUtf8() + ";SPEED=0");
+
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+    auto backend = BackendManager::instance()->load_backend_in_process(QStringLiteral("replay"));
+    QVERIFY(backend);
+    QCOMPARE(backend->config()->outputs().size(), 1);
+
+    std::vector<ConfigPtr> emitted;
+    connect(backend, &Backend::config_changed, this, [&emitted](auto const& config) {
+        emitted.push_back(config);
+    });
+    QTRY_COMPARE(emitted.size(), 3);
+
+    QCOMPARE(emitted.at(0)->outputs().size(), 2);
+    QCOMPARE(emitted.at(1)->outputs().size(), 1);
+    QCOMPARE(emitted.at(2)->outputs().size(), 2);
+}
+
+void TestReplay::testReplayPreparedUnplug()
+{
+    auto const path = m_dir.filePath(QStringLiteral("unplug.rec"));
+    {
+        Recording::Recorder recorder(path);
+        recorder.record(Recording::Event_type::initial, system_state(2));
+
+        // Leaves the backend time to prepare the configs for an unplug.
+        QTest::qWait(1500);
+        recorder.record(Recording::Event_type::change, system_state(1));
+    }
+    qputenv("DISMAN_BACKEND_ARGS", QByteArray("RECORDING=") + path.toUtf8() + ";SPEED=1");
+
+    auto prepared_count = [] {
+        auto const counters = Metrics::snapshot()[QStringLiteral("counters")].toMap();
+        return counters[QStringLiteral("prepared-configs-set")].toInt();
+    };
+    auto const count = prepared_count();
+
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+    auto backend = BackendManager::instance()->load_backend_in_process(QStringLiteral("replay"));
+    QVERIFY(backend);
+    QCOMPARE(backend->config()->outputs().size(), 2);
+
+    std::vector<ConfigPtr> emitted;
+    connect(backend, &Backend::config_changed, this, [&emitted](auto const& config) {
+        emitted.push_back(config);
+    });
+    QTRY_COMPARE_WITH_TIMEOUT(emitted.size(), 1, 5000);
+
+    QCOMPARE(emitted.at(0)->outputs().size(), 1);
+    QCOMPARE(prepared_count(), count + 1);
+}
+
+QTEST_GUILESS_MAIN(TestReplay)
+
+#include "testreplay.moc"
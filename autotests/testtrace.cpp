@@ -0,0 +1,157 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include <QtTest>
+
+#include "trace.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace Disman;
+
+class TestTrace : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void testDisabled();
+    void testSpans();
+    void testConcurrentDump();
+
+private:
+    QJsonArray read_events() const;
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+void TestTrace::init()
+{
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+    qputenv("DISMAN_TRACE", m_dir->path().toLocal8Bit());
+}
+
+void TestTrace::cleanup()
+{
+    Trace::detail::enabled = false;
+    Trace::set_current_id(0);
+    qunsetenv("DISMAN_TRACE");
+    m_dir.reset();
+}
+
+QJsonArray TestTrace::read_events() const
+{
+    auto const files = QDir(m_dir->path()).entryList(QDir::Files);
+    if (files.size() != 1) {
+        return QJsonArray();
+    }
+
+    QFile file(QDir(m_dir->path()).filePath(files.first()));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QJsonArray();
+    }
+    auto const trace = QJsonDocument::fromJson(file.readAll()).object();
+    return trace[QStringLiteral("traceEvents")].toArray();
+}
+
+void TestTrace::testDisabled()
+{
+    Trace::detail::enabled = false;
+
+    QCOMPARE(Trace::start_trace(), uint64_t(0));
+    {
+        DISMAN_TRACE_SPAN("disabled");
+    }
+    Trace::dump();
+
+    QVERIFY(QDir(m_dir->path()).entryList(QDir::Files).isEmpty());
+}
+
+void TestTrace::testSpans()
+{
+    Trace::detail::enabled = true;
+
+    auto const id = Trace::start_trace();
+    QVERIFY(id != 0);
+    QCOMPARE(Trace::current_id(), id);
+    {
+        DISMAN_TRACE_SPAN("outer");
+        DISMAN_TRACE_SPAN("inner");
+    }
+
+    Trace::set_current_id(0);
+    {
+        DISMAN_TRACE_SPAN("untraced");
+    }
+    Trace::dump();
+
+    auto const events = read_events();
+    QCOMPARE(events.size(), 3);
+
+    // Spans are recorded when they end.
+    auto const inner = events.at(0).toObject();
+    auto const outer = events.at(1).toObject();
+    auto const untraced = events.at(2).toObject();
+
+    QCOMPARE(inner[QStringLiteral("name")].toString(), QStringLiteral("inner"));
+    QCOMPARE(outer[QStringLiteral("name")].toString(), QStringLiteral("outer"));
+    QCOMPARE(untraced[QStringLiteral("name")].toString(), QStringLiteral("untraced"));
+    QCOMPARE(outer[QStringLiteral("ph")].toString(), QStringLiteral("X"));
+
+    QVERIFY(outer[QStringLiteral("ts")].toDouble() <= inner[QStringLiteral("ts")].toDouble());
+    QVERIFY(outer[QStringLiteral("dur")].toDouble() >= inner[QStringLiteral("dur")].toDouble());
+
+    auto const id_string = QString::number(id, 16);
+    QCOMPARE(outer[QStringLiteral("args")].toObject()[QStringLiteral("trace_id")].toString(),
+             id_string);
+    QCOMPARE(inner[QStringLiteral("args")].toObject()[QStringLiteral("trace_id")].toString(),
+             id_string);
+    QVERIFY(!untraced.contains(QStringLiteral("args")));
+}
+
+void TestTrace::testConcurrentDump()
+{
+    Trace::detail::enabled = true;
+
+    // Spans recorded while dumping are either complete in the trace or not in it at all.
+    std::atomic<bool> stop{false};
+    std::thread producer([&stop] {
+        Trace::start_trace();
+        while (!stop.load()) {
+            DISMAN_TRACE_SPAN("busy");
+        }
+    });
+
+    int broken{0};
+    for (int i = 0; i < 20; i++) {
+        Trace::dump();
+        for (auto const& value : read_events()) {
+            auto const event = value.toObject();
+            auto const name = event[QStringLiteral("name")].toString();
+            auto const known = name == QLatin1String("busy") || name == QLatin1String("inner")
+                || name == QLatin1String("outer") || name == QLatin1String("untraced");
+            if (!known || event[QStringLiteral("dur")].toDouble() < 0) {
+                broken++;
+            }
+        }
+    }
+
+    stop = true;
+    producer.join();
+    QCOMPARE(broken, 0);
+}
+
+QTEST_GUILESS_MAIN(TestTrace)
+
+#include "testtrace.moc"
@@ -8,10 +8,15 @@
 #include "device.h"
 #include "filer_controller.h"
 #include "generator.h"
+#include "log.h"
 #include "logging.h"
+#include "metrics.h"
 #include "output.h"
+#include "recording.h"
+#include "trace.h"
 
 #include <QRectF>
+#include <QTimer>
 
 namespace Disman
 {
@@ -20,19 +25,53 @@ BackendImpl::BackendImpl()
     : Backend()
     , m_device{new Device}
     , m_filer_controller{new Filer_controller(m_device.get())}
+    , m_settle_timer{new QTimer}
 {
     connect(m_device.get(), &Device::lid_open_changed, this, &BackendImpl::load_lid_config);
+
+    // Configs often change in bursts, for example while a dock connects its outputs one by one.
+    // Preparing transitions is also kept off the path that notifies clients about a change.
+    m_settle_timer->setInterval(500);
+    m_settle_timer->setSingleShot(true);
+    connect(m_settle_timer.get(), &QTimer::timeout, this, &BackendImpl::prepare_transitions);
+    connect(this, &Backend::config_changed, this, [this](auto const& config) {
+        m_emitted_config = config;
+        drop_lid_transitions();
+        m_unplug_configs.clear();
+        m_settle_timer->start();
+    });
 }
 
 BackendImpl::~BackendImpl() = default;
 
-void BackendImpl::init([[maybe_unused]] QVariantMap const& arguments)
+void BackendImpl::init(QVariantMap const& arguments)
 {
-    // noop, maybe overridden in individual backends.
+    // Individual backends that override this must call it too.
+    auto path = arguments.value(QStringLiteral("RECORD")).toString();
+    if (path.isEmpty()) {
+        path = QString::fromLocal8Bit(qgetenv("DISMAN_RECORD"));
+    }
+    if (path.isEmpty() || m_recorder) {
+        return;
+    }
+
+    m_recorder = std::make_unique<Recording::Recorder>(path);
+    if (!m_recorder->valid()) {
+        m_recorder.reset();
+        return;
+    }
+
+    qCDebug(DISMAN_BACKEND) << "Recording backend session to" << path;
+    connect(this, &Backend::config_changed, this, [this](auto const& config) {
+        m_recorder->record(Recording::Event_type::emitted, config);
+    });
 }
 
 Disman::ConfigPtr BackendImpl::config() const
 {
+    if (!m_config_initialized) {
+        m_settle_timer->start();
+    }
     m_config_initialized = true;
 
     auto config = config_impl();
@@ -46,6 +85,12 @@ Disman::ConfigPtr BackendImpl::config() const
 
 Disman::ConfigPtr BackendImpl::config_impl() const
 {
+    Metrics::count(QStringLiteral("configs-built"));
+
+    if (m_recorder && !m_system_state_recorded) {
+        record_system_state();
+    }
+
     auto config = std::make_shared<Config>();
 
     // We update from the windowing system first so the controller knows about the current
@@ -58,28 +103,40 @@ Disman::ConfigPtr BackendImpl::config_impl() const
     return config;
 }
 
-void BackendImpl::set_config(Disman::ConfigPtr const& config)
+Disman::ConfigPtr BackendImpl::set_config(Disman::ConfigPtr const& config)
 {
-    if (!config || config->compare(m_config)) {
+    if (!config) {
+        return m_config;
+    }
+    if (m_recorder) {
+        m_recorder->record(Recording::Event_type::requested, config);
+    }
+    if (config->compare(m_config)) {
         // No change by new config. Do nothing.
-        return;
+        return m_config;
     }
 
-    if (!set_config_impl(config)) {
-        // No change to the system but other changes that need to be synced with other Disman
-        // clients so emit a config_changed signal directly.
-        m_config = config;
-        Q_EMIT config_changed(config);
+    if (set_config_impl(config)) {
+        // The windowing system confirms the config later and we emit it from
+        // handle_config_change then, with the changes the windowing system made to it.
+        drop_lid_transitions();
+        return nullptr;
     }
+
+    // No change to the system but other changes that need to be synced with other Disman
+    // clients so emit a config_changed signal directly.
+    m_config = config;
+    Q_EMIT config_changed(config);
+    return config;
 }
 
 bool BackendImpl::set_config_impl(Disman::ConfigPtr const& config)
 {
-    if (QLoggingCategory category("disman.backend"); category.isEnabled(QtDebugMsg)) {
-        qCDebug(DISMAN_BACKEND) << "About to set config."
-                                << "\nPrevious config:" << this->config()
-                                << "\nNew config:" << config;
-    }
+    // The last known config instead of a rebuild from the windowing system, so that enabling debug
+    // output does not change what the backend does.
+    DISMAN_LOG_CONFIG(
+        DISMAN_BACKEND, QStringLiteral("About to set config. Previous config:"), m_config);
+    DISMAN_LOG_CONFIG(DISMAN_BACKEND, QStringLiteral("New config:"), config);
 
     m_filer_controller->write(config);
 
@@ -93,16 +150,46 @@ bool BackendImpl::set_config_impl(Disman::ConfigPtr const& config)
         }
     }
 
-    return set_config_system(config);
+    auto const applied = set_config_system(config);
+    if (m_recorder) {
+        m_recorder->record(Recording::Event_type::set, config, applied);
+    }
+    return applied;
 }
 
 bool BackendImpl::handle_config_change()
 {
+    DISMAN_TRACE_SPAN("BackendImpl::handle_config_change");
+
+    if (m_recorder) {
+        record_system_state();
+    }
+
+    if (!m_unplug_configs.empty()) {
+        auto system = std::make_shared<Config>();
+        update_config(system);
+
+        if (auto cfg = take_unplug_config(system)) {
+            qCDebug(DISMAN_BACKEND) << "Outputs unplugged. Setting prepared config.";
+            Metrics::count(QStringLiteral("prepared-configs-set"));
+
+            m_config = cfg;
+            m_filer_controller->reset_filer(cfg);
+            if (set_config_impl(cfg)) {
+                drop_lid_transitions();
+                return false;
+            }
+            Q_EMIT config_changed(cfg);
+            return true;
+        }
+    }
+
     // We need the config with its own cause, so we call config_impl here.
     auto cfg = config_impl();
 
     if (!m_config || m_config->hash() != cfg->hash()) {
-        qCDebug(DISMAN_BACKEND) << "Config with new output pattern received:" << cfg;
+        DISMAN_LOG_CONFIG(
+            DISMAN_BACKEND, QStringLiteral("Config with new output pattern received:"), cfg);
 
         if (cfg->cause() == Config::Cause::unknown) {
             qCDebug(DISMAN_BACKEND)
@@ -120,6 +207,7 @@ bool BackendImpl::handle_config_change()
 
         if (set_config_impl(cfg)) {
             qCDebug(DISMAN_BACKEND) << "Config for new output pattern sent.";
+            drop_lid_transitions();
             return false;
         }
     }
@@ -128,6 +216,125 @@ bool BackendImpl::handle_config_change()
     return true;
 }
 
+void BackendImpl::record_system_state() const
+{
+    auto config = std::make_shared<Config>();
+    update_config(config);
+
+    m_recorder->record(m_system_state_recorded ? Recording::Event_type::change
+                                               : Recording::Event_type::initial,
+                       config);
+    m_system_state_recorded = true;
+}
+
+void BackendImpl::prepare_transitions()
+{
+    DISMAN_TRACE_SPAN("BackendImpl::prepare_transitions");
+
+    // Before the first change there is only the config the windowing system started with.
+    auto const current = m_config ? m_config : config_impl();
+
+    prepare_lid_transitions(m_emitted_config ? m_emitted_config : current);
+    prepare_unplug_configs(current);
+}
+
+void BackendImpl::drop_lid_transitions()
+{
+    // Until the change settled a lid close computes its target from the current config.
+    m_lid_closed_config.reset();
+    m_filer_controller->drop_prepared_lid_file();
+}
+
+void BackendImpl::prepare_lid_transitions(ConfigPtr const& config)
+{
+    drop_lid_transitions();
+
+    if (!m_device->lid_present() || !m_device->lid_open() || config->outputs().size() == 1) {
+        return;
+    }
+
+    Generator generator(config);
+    if (!generator.disable_embedded()) {
+        return;
+    }
+
+    m_lid_closed_config = generator.config();
+    m_filer_controller->prepare_lid_file(config);
+}
+
+void BackendImpl::prepare_unplug_configs(ConfigPtr const& current)
+{
+    m_unplug_configs.clear();
+
+    if (current->outputs().size() < 2) {
+        return;
+    }
+
+    auto const embedded = Generator(current).embedded();
+
+    OutputMap externals;
+    for (auto const& [id, output] : current->outputs()) {
+        if (!embedded || id != embedded->id()) {
+            externals[id] = output;
+        }
+    }
+
+    auto add = [this, &current](OutputMap const& removed) {
+        auto config = prepare_unplug_config(current, removed);
+        m_unplug_configs[config->hash()] = config;
+    };
+
+    for (auto const& [id, output] : externals) {
+        add({{id, output}});
+    }
+    if (embedded && externals.size() > 1) {
+        // Back to the embedded display alone, like when undocking.
+        add(externals);
+    }
+}
+
+ConfigPtr BackendImpl::prepare_unplug_config(ConfigPtr const& current,
+                                             OutputMap const& removed) const
+{
+    auto config = current->clone();
+    for (auto const& [id, output] : removed) {
+        config->remove_output(id);
+    }
+    config->set_cause(Config::Cause::unknown);
+
+    // Same as in handle_config_change for a config with new output pattern.
+    if (!m_filer_controller->read_detached(config)) {
+        Generator generator(config);
+        generator.optimize();
+        config = generator.config();
+    }
+    return config;
+}
+
+ConfigPtr BackendImpl::take_unplug_config(ConfigPtr const& system)
+{
+    auto const it = m_unplug_configs.find(system->hash());
+    if (it == m_unplug_configs.end()) {
+        return nullptr;
+    }
+
+    auto config = it->second;
+    m_unplug_configs.clear();
+
+    // Output ids may have changed in the meantime, then the prepared config can not be used.
+    auto const outputs = config->outputs();
+    auto const system_outputs = system->outputs();
+    if (outputs.size() != system_outputs.size()) {
+        return nullptr;
+    }
+    for (auto const& [id, output] : outputs) {
+        if (system_outputs.find(id) == system_outputs.end()) {
+            return nullptr;
+        }
+    }
+    return config;
+}
+
 void BackendImpl::load_lid_config()
 {
     if (!m_config_initialized) {
@@ -136,6 +343,18 @@ void BackendImpl::load_lid_config()
         return;
     }
 
+    if (!m_device->lid_open() && m_lid_closed_config) {
+        // The config did not change since the last emission, so the precomputed target is current.
+        // Apply first and store the open-lid config afterwards to not delay turning off the panel.
+        qCDebug(DISMAN_BACKEND) << "Lid closed, applying prepared config.";
+        auto cfg = std::move(m_lid_closed_config);
+        set_config_impl(cfg);
+        if (!m_filer_controller->save_prepared_lid_file()) {
+            qCWarning(DISMAN_BACKEND) << "Failed to save open-lid file.";
+        }
+        return;
+    }
+
     auto cfg = config();
     if (cfg->outputs().size() == 1) {
         // Open-lid configuration is only relevant with more than one output.
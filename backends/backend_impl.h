@@ -8,13 +8,21 @@
 
 #include "backend.h"
 
+#include <map>
 #include <memory>
 
+class QTimer;
+
 namespace Disman
 {
 class Device;
 class Filer_controller;
 
+namespace Recording
+{
+class Recorder;
+}
+
 class BackendImpl : public Backend
 {
     Q_OBJECT
@@ -26,7 +34,7 @@ public:
     void init(const QVariantMap& arguments) override;
 
     ConfigPtr config() const override;
-    void set_config(ConfigPtr const& config) override;
+    ConfigPtr set_config(ConfigPtr const& config) override;
 
 protected:
     virtual void update_config(ConfigPtr& config) const = 0;
@@ -45,12 +53,47 @@ private:
 
     void load_lid_config();
 
+    /// Prepares lid close and unplug once the current config settled.
+    void prepare_transitions();
+
+    /// Computes in advance what a lid close does to @p config so the event only needs to apply it.
+    void prepare_lid_transitions(ConfigPtr const& config);
+
+    /// Drops the prepared lid close target while a config is being set.
+    void drop_lid_transitions();
+
+    /**
+     * Computes the configs to set when external outputs of @p current are unplugged: each on its
+     * own and all of them at once.
+     */
+    void prepare_unplug_configs(ConfigPtr const& current);
+    ConfigPtr prepare_unplug_config(ConfigPtr const& current, OutputMap const& removed) const;
+
+    /// Returns the prepared config for the windowing system state @p system if there is one.
+    ConfigPtr take_unplug_config(ConfigPtr const& system);
+
+    /// Records the windowing system state as the backend reports it before adapting it.
+    void record_system_state() const;
+
     std::unique_ptr<Device> m_device;
     std::unique_ptr<Filer_controller> m_filer_controller;
 
     mutable bool m_config_initialized{false};
 
+    // Only set when the session is recorded for later replay.
+    std::unique_ptr<Recording::Recorder> m_recorder;
+    mutable bool m_system_state_recorded{false};
+
     ConfigPtr m_config;
+    ConfigPtr m_emitted_config;
+
+    // Target on lid close for the config emitted last, refreshed once the current config settled.
+    // Reset on use.
+    ConfigPtr m_lid_closed_config;
+
+    // Targets on unplug by config hash, refreshed once the current config settled.
+    std::map<QString, ConfigPtr> m_unplug_configs;
+    std::unique_ptr<QTimer> m_settle_timer;
 };
 
 }
@@ -0,0 +1,612 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "control_store.h"
+
+#include "backendmanager_p.h"
+#include "logging.h"
+#include "metrics.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+namespace Disman
+{
+
+// The data file is rewritten when outdated records in it take up more than this and more than the
+// current records.
+constexpr qint64 min_rewrite_garbage{64 * 1024};
+
+static QString default_dir_path()
+{
+    auto path = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
+        + QStringLiteral("/disman/control/");
+
+    // Each instance has its own namespace so sessions with the same setup do not share control.
+    if (auto const instance = BackendManager::instance_name(); !instance.isEmpty()) {
+        path += QStringLiteral("instances/") + instance + QLatin1Char('/');
+    }
+    return path;
+}
+
+Control_store::Control_store()
+    : Control_store(default_dir_path())
+{
+}
+
+static std::vector<std::string> referenced_outputs(QVariantMap const& info)
+{
+    std::vector<std::string> outputs;
+    for (auto const& output : info[QStringLiteral("outputs")].toList()) {
+        outputs.push_back(output.toMap()[QStringLiteral("id")].toString().toStdString());
+    }
+    return outputs;
+}
+
+Control_store::Control_store(QString const& dir_path)
+    : m_dir_path{dir_path}
+{
+    m_warm_up = std::async(std::launch::async, [dir_path] {
+        auto data = read_data(dir_path);
+        if (compact_data(data, default_max_configs) > 0) {
+            // Removed records are dropped from the data file too.
+            write_data(dir_path, data, true);
+        }
+        preload(dir_path, data);
+        return data;
+    });
+}
+
+QString Control_store::file_path() const
+{
+    return store_path(m_dir_path);
+}
+
+Control_store::Data& Control_store::data() const
+{
+    if (m_warm_up.valid()) {
+        m_data = m_warm_up.get();
+    }
+    return m_data;
+}
+
+Control_store::Record& Control_store::loaded(Record& record) const
+{
+    if (!record.loaded) {
+        read_record(m_dir_path, data(), record);
+    }
+    return record;
+}
+
+void Control_store::sync()
+{
+    auto& data = this->data();
+    QFileInfo const file_info(file_path());
+
+    auto const changed = file_info.exists() ? file_info.lastModified() != data.file_time
+                                            : data.file_time.isValid();
+    if (changed) {
+        qCDebug(DISMAN_BACKEND) << "Control store changed on disk. Reloading.";
+        data = read_data(m_dir_path);
+    }
+}
+
+bool Control_store::has_config(std::string const& key) const
+{
+    auto const& configs = data().configs;
+    return configs.find(key) != configs.end();
+}
+
+QVariantMap Control_store::config_info(std::string const& key) const
+{
+    auto& configs = data().configs;
+    auto const it = configs.find(key);
+    return it == configs.end() ? QVariantMap() : loaded(it->second).info;
+}
+
+void Control_store::set_config_info(std::string const& key, QVariantMap const& info)
+{
+    auto& configs = data().configs;
+    if (info.isEmpty()) {
+        configs.erase(key);
+        return;
+    }
+
+    auto& record = configs[key];
+    record.info = info;
+    record.loaded = true;
+    record.unsaved = true;
+    record.last_write = QDateTime::currentSecsSinceEpoch();
+    record.outputs = referenced_outputs(info);
+}
+
+bool Control_store::move_config(std::string const& from, std::string const& to)
+{
+    auto& configs = data().configs;
+    auto node = configs.extract(from);
+    if (node.empty()) {
+        return false;
+    }
+
+    // Only the index changes, the record stays where it is in the data file.
+    configs.erase(to);
+    node.key() = to;
+    configs.insert(std::move(node));
+    return true;
+}
+
+QVariantMap Control_store::output_info(std::string const& hash) const
+{
+    auto& outputs = data().outputs;
+    auto const it = outputs.find(hash);
+    return it == outputs.end() ? QVariantMap() : loaded(it->second).info;
+}
+
+void Control_store::set_output_info(std::string const& hash, QVariantMap const& info)
+{
+    auto& outputs = data().outputs;
+    if (info.isEmpty()) {
+        outputs.erase(hash);
+        return;
+    }
+
+    auto& record = outputs[hash];
+    record.info = info;
+    record.loaded = true;
+    record.unsaved = true;
+}
+
+int Control_store::compact(size_t max_configs)
+{
+    return compact_data(data(), max_configs);
+}
+
+bool Control_store::save()
+{
+    return write_data(m_dir_path, data());
+}
+
+QString Control_store::store_path(QString const& dir_path)
+{
+    return QDir(dir_path).filePath(QStringLiteral("store.json"));
+}
+
+Control_store::Data Control_store::read_data(QString const& dir_path)
+{
+    Data data;
+
+    QFile file(store_path(dir_path));
+    if (!file.exists()) {
+        migrate(dir_path, data);
+        return data;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to open control store for reading."
+                                  << file.errorString();
+        return data;
+    }
+
+    data.file_time = QFileInfo(file).lastModified();
+    auto const obj = QJsonDocument::fromJson(file.readAll()).object();
+    Metrics::count(QStringLiteral("control-files-read"));
+
+    if (obj[QLatin1String("version")].toInt() < 2) {
+        // The records are in the index. Move them to a data file.
+        read_inline_records(obj, data);
+        write_data(dir_path, data, true);
+        return data;
+    }
+
+    data.data_file = obj[QLatin1String("data")].toString();
+    data.data_file_number = obj[QLatin1String("data-number")].toInt();
+
+    auto read_position = [](QJsonObject const& entry, Record& record) {
+        record.offset = entry[QLatin1String("offset")].toInteger(-1);
+        record.size = entry[QLatin1String("size")].toInteger();
+    };
+
+    auto const configs = obj[QLatin1String("configs")].toObject();
+    for (auto it = configs.begin(); it != configs.end(); ++it) {
+        auto const entry = it.value().toObject();
+        auto& record = data.configs[it.key().toStdString()];
+        read_position(entry, record);
+        record.last_write = entry[QLatin1String("last-write")].toInteger();
+        for (auto const& output : entry[QLatin1String("outputs")].toArray()) {
+            record.outputs.push_back(output.toString().toStdString());
+        }
+    }
+
+    auto const outputs = obj[QLatin1String("outputs")].toObject();
+    for (auto it = outputs.begin(); it != outputs.end(); ++it) {
+        read_position(it.value().toObject(), data.outputs[it.key().toStdString()]);
+    }
+
+    return data;
+}
+
+bool Control_store::read_record(QString const& dir_path, Data const& data, Record& record)
+{
+    // A failed read is not retried on every access.
+    record.loaded = true;
+    if (record.offset < 0) {
+        return true;
+    }
+
+    QFile file(QDir(dir_path).filePath(data.data_file));
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(record.offset)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to open control data for reading."
+                                  << file.errorString();
+        return false;
+    }
+
+    QJsonParseError error;
+    auto const doc = QJsonDocument::fromJson(file.read(record.size), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        qCWarning(DISMAN_BACKEND) << "Failed to parse control record at" << record.offset << "in"
+                                  << file.fileName() << error.errorString();
+        return false;
+    }
+
+    record.info = doc.object().toVariantMap();
+    Metrics::count(QStringLiteral("control-records-read"));
+    return true;
+}
+
+void Control_store::read_inline_records(QJsonObject const& obj, Data& data)
+{
+    auto const configs = obj[QLatin1String("configs")].toObject();
+    for (auto it = configs.begin(); it != configs.end(); ++it) {
+        auto const entry = it.value().toObject();
+        auto& record = data.configs[it.key().toStdString()];
+        record.info = entry[QLatin1String("info")].toObject().toVariantMap();
+        record.loaded = true;
+        record.unsaved = true;
+        record.last_write = entry[QLatin1String("last-write")].toInteger();
+        record.outputs = referenced_outputs(record.info);
+    }
+
+    auto const outputs = obj[QLatin1String("outputs")].toObject();
+    for (auto it = outputs.begin(); it != outputs.end(); ++it) {
+        auto& record = data.outputs[it.key().toStdString()];
+        record.info = it.value().toObject().toVariantMap();
+        record.loaded = true;
+        record.unsaved = true;
+    }
+}
+
+int Control_store::compact_data(Data& data, size_t max_configs)
+{
+    int removed = 0;
+
+    if (data.configs.size() > max_configs) {
+        std::vector<std::pair<qint64, std::string>> writes;
+        for (auto const& [key, record] : data.configs) {
+            writes.push_back({record.last_write, key});
+        }
+        std::sort(writes.begin(), writes.end());
+
+        auto const excess = data.configs.size() - max_configs;
+        for (size_t i = 0; i < excess; i++) {
+            data.configs.erase(writes.at(i).second);
+            removed++;
+        }
+    }
+
+    // The index knows the outputs of each config, no record needs to be read for this.
+    std::unordered_set<std::string> referenced;
+    for (auto const& [key, record] : data.configs) {
+        referenced.insert(record.outputs.cbegin(), record.outputs.cend());
+    }
+    for (auto it = data.outputs.begin(); it != data.outputs.end();) {
+        if (referenced.count(it->first)) {
+            ++it;
+            continue;
+        }
+        it = data.outputs.erase(it);
+        removed++;
+    }
+
+    if (removed) {
+        qCDebug(DISMAN_BACKEND) << "Removed" << removed << "stale records from control store.";
+    }
+    return removed;
+}
+
+bool Control_store::write_data(QString const& dir_path, Data& data, bool rewrite)
+{
+    if (!QDir().mkpath(dir_path)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to create control directory" << dir_path;
+        return false;
+    }
+
+    auto const old_file = data.data_file;
+    if (!rewrite) {
+        QFileInfo const data_info(QDir(dir_path).filePath(data.data_file));
+
+        qint64 current = 0;
+        auto count = [&current](Record const& record) {
+            if (!record.unsaved && record.offset >= 0) {
+                current += record.size;
+            }
+        };
+        for (auto const& [key, record] : data.configs) {
+            count(record);
+        }
+        for (auto const& [hash, record] : data.outputs) {
+            count(record);
+        }
+
+        auto const outdated = data_info.size() - current;
+        rewrite = data.data_file.isEmpty() || !data_info.exists()
+            || (outdated > min_rewrite_garbage && outdated > current);
+    }
+
+    if (!(rewrite ? rewrite_records(dir_path, data) : append_records(dir_path, data))) {
+        return false;
+    }
+    if (!write_index(dir_path, data)) {
+        return false;
+    }
+
+    // The old data file is only removed once the index does not point to it anymore.
+    if (!old_file.isEmpty() && old_file != data.data_file) {
+        QFile::remove(QDir(dir_path).filePath(old_file));
+    }
+    return true;
+}
+
+QByteArray Control_store::serialize(std::vector<Record*> const& records,
+                                    std::vector<std::pair<qint64, qint64>>& positions)
+{
+    QByteArray bytes;
+    for (auto const record : records) {
+        auto const doc = QJsonDocument(QJsonObject::fromVariantMap(record->info));
+        auto const line = doc.toJson(QJsonDocument::Compact) + '\n';
+        positions.push_back({bytes.size(), line.size()});
+        bytes += line;
+    }
+    return bytes;
+}
+
+bool Control_store::append_records(QString const& dir_path, Data& data)
+{
+    std::vector<Record*> records;
+    for (auto& [key, record] : data.configs) {
+        if (record.unsaved) {
+            records.push_back(&record);
+        }
+    }
+    for (auto& [hash, record] : data.outputs) {
+        if (record.unsaved) {
+            records.push_back(&record);
+        }
+    }
+    if (records.empty()) {
+        return true;
+    }
+
+    std::vector<std::pair<qint64, qint64>> positions;
+    auto const bytes = serialize(records, positions);
+
+    QFile file(QDir(dir_path).filePath(data.data_file));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to open control data for writing."
+                                  << file.errorString();
+        return false;
+    }
+
+    // A partly written line at the end is never referenced by the index.
+    auto const end = file.size();
+    if (file.write(bytes) != bytes.size() || !file.flush()) {
+        qCWarning(DISMAN_BACKEND) << "Failed to append control records." << file.errorString();
+        return false;
+    }
+
+    for (size_t i = 0; i < records.size(); i++) {
+        records.at(i)->offset = end + positions.at(i).first;
+        records.at(i)->size = positions.at(i).second;
+        records.at(i)->unsaved = false;
+    }
+    Metrics::count(QStringLiteral("control-records-written"), records.size());
+    return true;
+}
+
+bool Control_store::rewrite_records(QString const& dir_path, Data& data)
+{
+    std::vector<Record*> records;
+    auto add_all = [&](auto& map) {
+        for (auto it = map.begin(); it != map.end();) {
+            auto& record = it->second;
+            if (!record.loaded && !read_record(dir_path, data, record)) {
+                qCWarning(DISMAN_BACKEND) << "Dropping unreadable control record"
+                                          << QString::fromStdString(it->first);
+                it = map.erase(it);
+                continue;
+            }
+            records.push_back(&record);
+            ++it;
+        }
+    };
+    add_all(data.configs);
+    add_all(data.outputs);
+
+    std::vector<std::pair<qint64, qint64>> positions;
+    auto const bytes = serialize(records, positions);
+
+    auto const number = data.data_file_number + 1;
+    auto const name = QStringLiteral("store-%1.data").arg(number);
+
+    QSaveFile file(QDir(dir_path).filePath(name));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to open control data for writing."
+                                  << file.errorString();
+        return false;
+    }
+    file.write(bytes);
+    if (!file.commit()) {
+        qCWarning(DISMAN_BACKEND) << "Failed to write control data." << file.errorString();
+        return false;
+    }
+
+    for (size_t i = 0; i < records.size(); i++) {
+        records.at(i)->offset = positions.at(i).first;
+        records.at(i)->size = positions.at(i).second;
+        records.at(i)->unsaved = false;
+    }
+    data.data_file = name;
+    data.data_file_number = number;
+
+    Metrics::count(QStringLiteral("control-records-written"), records.size());
+    return true;
+}
+
+bool Control_store::write_index(QString const& dir_path, Data& data)
+{
+    auto position = [](Record const& record) {
+        QJsonObject obj;
+        obj[QLatin1String("offset")] = record.offset;
+        obj[QLatin1String("size")] = record.size;
+        return obj;
+    };
+
+    QJsonObject configs;
+    for (auto const& [key, record] : data.configs) {
+        auto obj = position(record);
+        obj[QLatin1String("last-write")] = record.last_write;
+
+        QJsonArray outputs;
+        for (auto const& hash : record.outputs) {
+            outputs.push_back(QString::fromStdString(hash));
+        }
+        obj[QLatin1String("outputs")] = outputs;
+        configs[QString::fromStdString(key)] = obj;
+    }
+
+    QJsonObject outputs;
+    for (auto const& [hash, record] : data.outputs) {
+        outputs[QString::fromStdString(hash)] = position(record);
+    }
+
+    QJsonObject obj;
+    obj[QLatin1String("version")] = 2;
+    obj[QLatin1String("data")] = data.data_file;
+    obj[QLatin1String("data-number")] = data.data_file_number;
+    obj[QLatin1String("configs")] = configs;
+    obj[QLatin1String("outputs")] = outputs;
+
+    // Written to a temporary file first so a crash never leaves a truncated index behind.
+    auto const path = store_path(dir_path);
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to open control store for writing."
+                                  << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qCWarning(DISMAN_BACKEND) << "Failed to write control store." << file.errorString();
+        return false;
+    }
+
+    data.file_time = QFileInfo(path).lastModified();
+    qCDebug(DISMAN_BACKEND) << "Control saved to:" << path;
+    Metrics::count(QStringLiteral("control-files-written"));
+    return true;
+}
+
+void Control_store::preload(QString const& dir_path, Data& data)
+{
+    std::vector<std::pair<qint64, Config_record*>> recent;
+    for (auto& [key, record] : data.configs) {
+        recent.push_back({record.last_write, &record});
+    }
+
+    auto const count = std::min(preloaded_configs, recent.size());
+    std::partial_sort(recent.begin(),
+                      recent.begin() + count,
+                      recent.end(),
+                      [](auto const& a, auto const& b) { return a.first > b.first; });
+
+    for (size_t i = 0; i < count; i++) {
+        auto& config = *recent.at(i).second;
+        if (!config.loaded) {
+            read_record(dir_path, data, config);
+        }
+        for (auto const& hash : config.outputs) {
+            auto const it = data.outputs.find(hash);
+            if (it != data.outputs.end() && !it->second.loaded) {
+                read_record(dir_path, data, it->second);
+            }
+        }
+    }
+}
+
+void Control_store::migrate(QString const& dir_path, Data& data)
+{
+    QDir const dir(dir_path);
+    QStringList migrated;
+
+    auto read_dir = [&](QString const& name, auto insert) {
+        QDir const sub_dir(dir.filePath(name));
+        auto const files = sub_dir.entryInfoList({QStringLiteral("*.json")}, QDir::Files);
+        for (auto const& file_info : files) {
+            QFile file(file_info.filePath());
+            if (!file.open(QIODevice::ReadOnly)) {
+                qCWarning(DISMAN_BACKEND) << "Failed to open control file for migration."
+                                          << file.errorString();
+                continue;
+            }
+            auto const info = QJsonDocument::fromJson(file.readAll()).toVariant().toMap();
+            if (!info.isEmpty()) {
+                insert(file_info, info);
+            }
+            migrated.push_back(file_info.filePath());
+        }
+    };
+
+    auto insert_config = [&data](QFileInfo const& file_info, QVariantMap const& info) {
+        auto& record = data.configs[file_info.completeBaseName().toStdString()];
+        record.info = info;
+        record.loaded = true;
+        record.unsaved = true;
+        record.last_write = file_info.lastModified().toSecsSinceEpoch();
+        record.outputs = referenced_outputs(info);
+    };
+    auto insert_output = [&data](QFileInfo const& file_info, QVariantMap const& info) {
+        auto& record = data.outputs[file_info.completeBaseName().toStdString()];
+        record.info = info;
+        record.loaded = true;
+        record.unsaved = true;
+    };
+    read_dir(QStringLiteral("configs"), insert_config);
+    read_dir(QStringLiteral("outputs"), insert_output);
+
+    if (migrated.isEmpty()) {
+        return;
+    }
+
+    qCDebug(DISMAN_BACKEND) << "Migrating" << migrated.size() << "control files to"
+                            << store_path(dir_path);
+    if (!write_data(dir_path, data, true)) {
+        return;
+    }
+
+    for (auto const& path : qAsConst(migrated)) {
+        QFile::remove(path);
+    }
+    dir.rmdir(QStringLiteral("configs"));
+    dir.rmdir(QStringLiteral("outputs"));
+}
+
+}
@@ -0,0 +1,141 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include <QDateTime>
+#include <QString>
+#include <QVariantMap>
+
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class QJsonObject;
+
+namespace Disman
+{
+
+/**
+ * Control data in an index and a data file. The index tells for each config hash and each output
+ * hash where its record is in the data file. For configs it also holds when they were last
+ * written and the outputs they refer to. It is read once and afterwards only again when another
+ * process changed it, so existence checks and compaction do not touch the disk.
+ *
+ * Records are only read from the data file on first access. Loading the control of a config reads
+ * the config record and the records of its outputs but nothing else.
+ *
+ * Saving appends the changed records to the data file and rewrites the index. The index is small
+ * compared to the records, so the cost of a save grows with the changed records and only slowly
+ * with the number of known configs. Outdated records remain in the data file until they take up
+ * more space than the current ones. Then the data file is rewritten with current records only.
+ *
+ * Control data in the layout of one file per config and per output that was used before, and
+ * stores that held all records in the index file, are migrated on first load.
+ *
+ * The first load runs on a worker thread started on construction, so that reading the index and
+ * the records of recently written configs at service start overlaps with the windowing system
+ * setup. Any access waits for it.
+ */
+class Control_store
+{
+public:
+    /// Uses the control directory of the instance in the user's data location.
+    Control_store();
+    explicit Control_store(QString const& dir_path);
+
+    /// Reloads the store when its index was changed by someone else since the last load or save.
+    void sync();
+
+    bool has_config(std::string const& key) const;
+    QVariantMap config_info(std::string const& key) const;
+
+    /// An empty @p info removes the record.
+    void set_config_info(std::string const& key, QVariantMap const& info);
+    bool move_config(std::string const& from, std::string const& to);
+
+    QVariantMap output_info(std::string const& hash) const;
+
+    /// An empty @p info removes the record.
+    void set_output_info(std::string const& hash, QVariantMap const& info);
+
+    /**
+     * Removes output records that no config record refers to and the least recently written
+     * config records above @p max_configs.
+     *
+     * @return number of removed records
+     */
+    int compact(size_t max_configs = default_max_configs);
+
+    bool save();
+
+    /// The index file.
+    QString file_path() const;
+
+private:
+    static constexpr size_t default_max_configs{100};
+
+    // Records of this many of the most recently written configs are loaded on warm-up.
+    static constexpr size_t preloaded_configs{8};
+
+    struct Record {
+        QVariantMap info;
+
+        // Position in the data file. Negative while the record was not yet written.
+        qint64 offset{-1};
+        qint64 size{0};
+
+        bool loaded{false};
+        bool unsaved{false};
+    };
+
+    struct Config_record : Record {
+        qint64 last_write{0};
+        std::vector<std::string> outputs;
+    };
+
+    struct Data {
+        std::unordered_map<std::string, Config_record> configs;
+        std::unordered_map<std::string, Record> outputs;
+
+        // Name of the data file in the directory. A rewrite creates a new one.
+        QString data_file;
+        int data_file_number{0};
+
+        QDateTime file_time;
+    };
+
+    /// Waits for the warm-up on first use.
+    Data& data() const;
+
+    /// Reads the record from the data file on first access.
+    Record& loaded(Record& record) const;
+
+    // These run on the warm-up thread too and must therefore only work on the passed data.
+    static Data read_data(QString const& dir_path);
+    static bool read_record(QString const& dir_path, Data const& data, Record& record);
+    static void read_inline_records(QJsonObject const& obj, Data& data);
+    static void migrate(QString const& dir_path, Data& data);
+    static void preload(QString const& dir_path, Data& data);
+    static int compact_data(Data& data, size_t max_configs);
+    static bool write_data(QString const& dir_path, Data& data, bool rewrite = false);
+    static bool append_records(QString const& dir_path, Data& data);
+    static bool rewrite_records(QString const& dir_path, Data& data);
+    static bool write_index(QString const& dir_path, Data& data);
+    static QString store_path(QString const& dir_path);
+
+    /// Serializes @p records one per line and adds their offset and size in the result.
+    static QByteArray serialize(std::vector<Record*> const& records,
+                                std::vector<std::pair<qint64, qint64>>& positions);
+
+    QString m_dir_path;
+
+    mutable std::future<Data> m_warm_up;
+    mutable Data m_data;
+};
+
+}
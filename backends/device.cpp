@@ -6,6 +6,7 @@
 #include "device.h"
 
 #include "freedesktop_interface.h"
+#include "lid_switch.h"
 #include "logging.h"
 
 #include <QDBusConnection>
@@ -21,6 +22,28 @@ Device::Device(QObject* parent)
     m_lid_timer->setSingleShot(true);
     connect(m_lid_timer.get(), &QTimer::timeout, this, &Device::lid_open_changed);
 
+    m_lid_switch.reset(new Lid_switch(QString::fromLocal8Bit(qgetenv("DISMAN_LID_DEVICE"))));
+    if (m_lid_switch->valid()) {
+        m_lid_present = true;
+        m_lid_closed = m_lid_switch->closed();
+        m_ready = true;
+        connect(m_lid_switch.get(), &Lid_switch::closed_changed, this, &Device::set_lid_closed);
+        connect(m_lid_switch.get(), &Lid_switch::lost, this, &Device::lid_switch_lost);
+        connect_login1();
+        return;
+    }
+    m_lid_switch.reset();
+
+    if (!connect_upower() || !connect_login1()) {
+        return;
+    }
+    fetch_lid_present();
+}
+
+Device::~Device() = default;
+
+bool Device::connect_upower()
+{
     m_upower = new OrgFreedesktopDBusPropertiesInterface(QStringLiteral("org.freedesktop.UPower"),
                                                          QStringLiteral("/org/freedesktop/UPower"),
                                                          QDBusConnection::systemBus(),
@@ -28,33 +51,49 @@ Device::Device(QObject* parent)
     if (!m_upower->isValid()) {
         qCDebug(DISMAN_BACKEND) << "UPower not available, no lid detection."
                                 << m_upower->lastError().message();
-        return;
+        return false;
     }
 
-    QDBusConnection::systemBus().connect(QStringLiteral("org.freedesktop.UPower"),
-                                         QStringLiteral("/org/freedesktop/UPower"),
-                                         QStringLiteral("org.freedesktop.DBus.Properties"),
-                                         QStringLiteral("PropertiesChanged"),
-                                         this,
-                                         SLOT(fetch_lid_closed()));
+    QDBusConnection::systemBus().connect(
+        QStringLiteral("org.freedesktop.UPower"),
+        QStringLiteral("/org/freedesktop/UPower"),
+        QStringLiteral("org.freedesktop.DBus.Properties"),
+        QStringLiteral("PropertiesChanged"),
+        this,
+        SLOT(upower_properties_changed(QString, QVariantMap, QStringList)));
+    return true;
+}
+
+void Device::lid_switch_lost()
+{
+    qCWarning(DISMAN_BACKEND) << "Lid switch lost. Taking the lid state from UPower.";
+
+    // Emitted by the switch itself.
+    m_lid_switch.release()->deleteLater();
+
+    if (!connect_upower()) {
+        // Without any source the last known state is kept.
+        return;
+    }
+    fetch_lid_present();
+}
 
+bool Device::connect_login1()
+{
     m_login1 = new QDBusInterface(QStringLiteral("org.freedesktop.login1"),
                                   QStringLiteral("/org/freedesktop/login1"),
                                   QStringLiteral("org.freedesktop.login1.Manager"),
                                   QDBusConnection::systemBus(),
                                   this);
     if (!m_login1->isValid()) {
-        qCDebug(DISMAN_BACKEND) << "logind not available, no lid detection."
-                                << m_login1->lastError().message();
-        return;
+        qCDebug(DISMAN_BACKEND) << "logind not available." << m_login1->lastError().message();
+        return false;
     }
 
     connect(m_login1, SIGNAL(PrepareForSleep(bool)), this, SLOT(prepare_for_sleep(bool)));
-    fetch_lid_present();
+    return true;
 }
 
-Device::~Device() = default;
-
 bool Device::lid_present() const
 {
     return m_lid_present;
@@ -115,7 +154,28 @@ void Device::lid_closed_fetched(QDBusPendingCallWatcher* watcher)
 
     auto const closed = reply.value().toBool();
     watcher->deleteLater();
+    set_lid_closed(closed);
+}
 
+void Device::upower_properties_changed(QString const& interface,
+                                       QVariantMap const& changed,
+                                       QStringList const& invalidated)
+{
+    if (interface != QStringLiteral("org.freedesktop.UPower")) {
+        return;
+    }
+
+    // UPower sends the new value along, only an invalidated one must be fetched.
+    auto const it = changed.constFind(QStringLiteral("LidIsClosed"));
+    if (it != changed.constEnd()) {
+        set_lid_closed(it->toBool());
+    } else if (invalidated.contains(QStringLiteral("LidIsClosed"))) {
+        fetch_lid_closed();
+    }
+}
+
+void Device::set_lid_closed(bool closed)
+{
     if (closed == m_lid_closed) {
         return;
     }
@@ -12,6 +12,8 @@
 #include <QString>
 #include <memory>
 
+#include <QVariantMap>
+
 class OrgFreedesktopDBusPropertiesInterface;
 class QDBusPendingCallWatcher;
 class QDBusInterface;
@@ -19,7 +21,13 @@ class QTimer;
 
 namespace Disman
 {
+class Lid_switch;
 
+/**
+ * Hardware state relevant to output configuration. The lid state is read from the evdev lid
+ * switch when possible, otherwise from UPower. The environment variable DISMAN_LID_DEVICE selects
+ * a specific input device node. When the lid switch is lost at runtime UPower takes over.
+ */
 class Device : public QObject
 {
     Q_OBJECT
@@ -35,11 +43,18 @@ Q_SIGNALS:
     void lid_open_changed();
 
 private Q_SLOTS:
-    void fetch_lid_closed();
+    void upower_properties_changed(QString const& interface,
+                                   QVariantMap const& changed,
+                                   QStringList const& invalidated);
     void prepare_for_sleep(bool start);
 
 private:
-    void set_ready();
+    bool connect_login1();
+    bool connect_upower();
+    void lid_switch_lost();
+
+    void fetch_lid_closed();
+    void set_lid_closed(bool closed);
 
     void fetch_lid_present();
     void lid_present_fetched(QDBusPendingCallWatcher* watcher);
@@ -51,6 +66,7 @@ private:
     bool m_lid_closed{false};
 
     std::unique_ptr<QTimer> m_lid_timer;
+    std::unique_ptr<Lid_switch> m_lid_switch;
 
     OrgFreedesktopDBusPropertiesInterface* m_upower{nullptr};
     QDBusInterface* m_login1{nullptr};
@@ -21,17 +21,18 @@
 #include "fake_logging.h"
 
 #include "config.h"
+#include <mode.h>
 #include <output.h>
+#include <trace.h>
+
+#include "synthetic.h"
 
 #include <stdlib.h>
 
 #include <QFile>
+#include <QFileSystemWatcher>
 #include <QTimer>
 
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
-
 #include <QDBusConnection>
 
 #include "fakebackendadaptor.h"
@@ -40,9 +41,12 @@ using namespace Disman;
 
 Fake::Fake()
     : Disman::BackendImpl()
+    , m_watcher{new QFileSystemWatcher(this)}
 {
     QLoggingCategory::setFilterRules(QStringLiteral("disman.fake.debug = true"));
 
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &Fake::handle_file_change);
+
     if (qgetenv("DISMAN_IN_PROCESS") != QByteArray("1")) {
         QTimer::singleShot(0, this, &Fake::delayedInit);
     }
@@ -50,10 +54,43 @@ Fake::Fake()
 
 void Fake::init(const QVariantMap& arguments)
 {
-    mConfig.reset();
+    BackendImpl::init(arguments);
+
+    m_model.reset();
+    m_edids.clear();
+
+    if (!m_watcher->files().isEmpty()) {
+        m_watcher->removePaths(m_watcher->files());
+    }
+
+    m_initializing = false;
+    m_init_failed = false;
+    if (auto const delay = arguments[QStringLiteral("INIT_DELAY")].toInt(); delay > 0) {
+        auto const fail = arguments.contains(QStringLiteral("INIT_FAIL"));
+        m_initializing = true;
+        QTimer::singleShot(delay, this, [this, fail] {
+            m_initializing = false;
+            m_init_failed = fail;
+            Q_EMIT init_finished();
+        });
+    }
+
+    m_synthetic_outputs = arguments[QStringLiteral("SYNTHETIC_OUTPUTS")].toInt();
+    if (arguments.contains(QStringLiteral("SYNTHETIC_MODES"))) {
+        m_synthetic_modes = arguments[QStringLiteral("SYNTHETIC_MODES")].toInt();
+    }
+    if (m_synthetic_outputs > 0) {
+        qCDebug(DISMAN_FAKE) << "Fake synthetic config:" << m_synthetic_outputs << "outputs with"
+                             << m_synthetic_modes << "modes";
+        return;
+    }
 
     mConfigFile = arguments[QStringLiteral("TEST_DATA")].toString();
     qCDebug(DISMAN_FAKE) << "Fake profile file:" << mConfigFile;
+
+    if (!mConfigFile.isEmpty()) {
+        m_watcher->addPath(mConfigFile);
+    }
 }
 
 void Fake::delayedInit()
@@ -76,117 +113,180 @@ QString Fake::service_name() const
     return QStringLiteral("org.kwinft.disman.fakebackend");
 }
 
+void Fake::load_model() const
+{
+    if (m_synthetic_outputs > 0) {
+        m_model = synthetic_config(m_synthetic_outputs, m_synthetic_modes);
+        m_edids.clear();
+        return;
+    }
+
+    m_model = std::make_shared<Config>();
+
+    QFile file(mConfigFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(DISMAN_FAKE) << "Failed to open" << mConfigFile << file.errorString();
+        m_edids.clear();
+        return;
+    }
+
+    auto const data = file.readAll();
+    Parser::fromJson(data, m_model);
+    m_edids = Parser::edidsFromJson(data);
+}
+
+Disman::ConfigPtr const& Fake::model() const
+{
+    if (!m_model) {
+        load_model();
+    }
+    return m_model;
+}
+
 void Fake::update_config(ConfigPtr& config) const
 {
-    Parser::fromJson(mConfigFile, config);
-    mConfig = config;
+    // Hand out copies so the caller can not change the model behind our back.
+    auto const snapshot = model()->clone();
+    config->setScreen(snapshot->screen());
+    if (snapshot->outputs().empty()) {
+        return;
+    }
+    config->set_outputs(snapshot->outputs());
+    config->set_primary_output(snapshot->primary_output());
 }
 
 bool Fake::set_config_system(const ConfigPtr& config)
 {
-    mConfig = config->clone();
-    emit config_changed(mConfig);
+    emit config_changed(config->clone());
     return true;
 }
 
 bool Fake::valid() const
 {
-    return true;
+    return !m_init_failed;
+}
+
+bool Fake::initializing() const
+{
+    return m_initializing;
 }
 
 QByteArray Fake::edid(int outputId) const
 {
-    Q_UNUSED(outputId);
-    QFile file(mConfigFile);
-    file.open(QIODevice::ReadOnly);
+    model();
+    return m_edids.value(outputId);
+}
 
-    const QJsonDocument jsonDoc = QJsonDocument::fromJson(file.readAll());
-    const QJsonObject json = jsonDoc.object();
+void Fake::handle_file_change(QString const& path)
+{
+    // Editors often replace the file, which removes it from the watcher.
+    if (!m_watcher->files().contains(path) && QFile::exists(path)) {
+        m_watcher->addPath(path);
+    }
 
-    const QJsonArray outputs = json[QStringLiteral("outputs")].toArray();
-    Q_FOREACH (const QJsonValue& value, outputs) {
-        const QVariantMap output = value.toObject().toVariantMap();
-        if (output[QStringLiteral("id")].toInt() != outputId) {
-            continue;
-        }
+    qCDebug(DISMAN_FAKE) << "Fake profile file changed. Reloading.";
+    load_model();
+    emit_model_changed();
+}
 
-        return QByteArray::fromBase64(output[QStringLiteral("edid")].toByteArray());
-    }
-    return QByteArray();
+void Fake::emit_model_changed()
+{
+    Q_EMIT config_changed(config());
 }
 
 void Fake::setEnabled(int outputId, bool enabled)
 {
-    Disman::OutputPtr output = config()->output(outputId);
-    if (output->enabled() == enabled) {
+    auto output = model()->output(outputId);
+    if (!output || output->enabled() == enabled) {
         return;
     }
 
     output->set_enabled(enabled);
-    Q_EMIT config_changed(mConfig);
+    emit_model_changed();
 }
 
 void Fake::setPrimary(int outputId, bool primary)
 {
-    auto output = config()->output(outputId);
+    auto output = model()->output(outputId);
+    if (!output) {
+        return;
+    }
 
     if (primary) {
-        if (auto cur_prim = mConfig->primary_output()) {
+        if (auto cur_prim = m_model->primary_output()) {
             if (output == cur_prim) {
                 return;
             }
-            mConfig->set_primary_output(output);
+            m_model->set_primary_output(output);
         }
     } else {
-        if (auto cur_prim = mConfig->primary_output()) {
+        if (auto cur_prim = m_model->primary_output()) {
             if (output != cur_prim) {
                 return;
             }
-            mConfig->set_primary_output(nullptr);
+            m_model->set_primary_output(nullptr);
         }
     }
 
-    Q_EMIT config_changed(mConfig);
+    emit_model_changed();
 }
 
 void Fake::setCurrentModeId(int outputId, QString const& modeId)
 {
     std::string const& string_mode_id = modeId.toStdString();
-    auto output = config()->output(outputId);
+    auto output = model()->output(outputId);
+    if (!output) {
+        return;
+    }
 
     if (auto mode = output->commanded_mode(); mode && mode->id() == string_mode_id) {
         return;
     }
 
     output->set_mode(output->mode(string_mode_id));
-    Q_EMIT config_changed(mConfig);
+    emit_model_changed();
 }
 
 void Fake::setRotation(int outputId, int rotation)
 {
-    Disman::OutputPtr output = config()->output(outputId);
+    auto output = model()->output(outputId);
     const Disman::Output::Rotation rot = static_cast<Disman::Output::Rotation>(rotation);
-    if (output->rotation() == rot) {
+    if (!output || output->rotation() == rot) {
         return;
     }
 
     output->set_rotation(rot);
-    Q_EMIT config_changed(mConfig);
+    emit_model_changed();
 }
 
 void Fake::addOutput(int outputId, const QString& name)
 {
+    Disman::Trace::start_trace();
+
     Disman::OutputPtr output(new Disman::Output);
     output->set_id(outputId);
     output->set_name(name.toStdString());
     output->set_description(name.toStdString());
     output->set_hash(name.toStdString());
-    mConfig->add_output(output);
-    Q_EMIT config_changed(mConfig);
+
+    // Outputs need at least one mode to be serialized. Give hotplugged ones a common default.
+    Disman::ModePtr mode(new Disman::Mode);
+    mode->set_id("1");
+    mode->set_name("1920x1080@60");
+    mode->set_size(QSize(1920, 1080));
+    mode->set_refresh(60000);
+    output->set_modes({{mode->id(), mode}});
+    output->set_preferred_modes({mode->id()});
+    output->set_mode(mode);
+
+    model()->add_output(output);
+    emit_model_changed();
 }
 
 void Fake::removeOutput(int outputId)
 {
-    mConfig->remove_output(outputId);
-    Q_EMIT config_changed(mConfig);
+    Disman::Trace::start_trace();
+
+    model()->remove_output(outputId);
+    emit_model_changed();
 }
@@ -21,9 +21,12 @@
 #include "backend_impl.h"
 
 #include <QLoggingCategory>
+#include <QMap>
 #include <QObject>
 #include <memory>
 
+class QFileSystemWatcher;
+
 class Fake : public Disman::BackendImpl
 {
     Q_OBJECT
@@ -42,6 +45,7 @@ public:
     bool set_config_system(Disman::ConfigPtr const& config) override;
 
     bool valid() const override;
+    bool initializing() const override;
 
     void setEnabled(int outputId, bool enabled);
     void setPrimary(int outputId, bool primary);
@@ -56,8 +60,26 @@ private Q_SLOTS:
 private:
     QByteArray edid(int outputId) const;
 
+    /// Parses the test file or synthesizes a config. Loading is deferred to the first use.
+    void load_model() const;
+    Disman::ConfigPtr const& model() const;
+    void handle_file_change(QString const& path);
+    void emit_model_changed();
+
     QString mConfigFile;
-    mutable Disman::ConfigPtr mConfig;
+    QFileSystemWatcher* m_watcher{nullptr};
+
+    // When positive a config with this many outputs is synthesized instead of reading a file.
+    int m_synthetic_outputs{0};
+    int m_synthetic_modes{10};
+
+    // Simulates a backend that connects asynchronously to the windowing system.
+    bool m_initializing{false};
+    bool m_init_failed{false};
+
+    // The simulated windowing system state. Changed by the D-Bus methods and file changes.
+    mutable Disman::ConfigPtr m_model;
+    mutable QMap<int, QByteArray> m_edids;
 };
 
 #endif
@@ -73,6 +73,20 @@ void Parser::fromJson(const QString& path, Disman::ConfigPtr& config)
     Parser::fromJson(file.readAll(), config);
 }
 
+QMap<int, QByteArray> Parser::edidsFromJson(const QByteArray& data)
+{
+    QMap<int, QByteArray> edids;
+
+    const QJsonArray outputs
+        = QJsonDocument::fromJson(data).object()[QStringLiteral("outputs")].toArray();
+    for (auto const& value : outputs) {
+        auto const output = value.toObject();
+        edids.insert(output[QStringLiteral("id")].toInt(),
+                     QByteArray::fromBase64(output[QStringLiteral("edid")].toString().toLatin1()));
+    }
+    return edids;
+}
+
 ScreenPtr Parser::screenFromJson(const QVariantMap& data)
 {
     ScreenPtr screen(new Screen);
@@ -19,6 +19,7 @@
 #define PARSER_H
 
 #include <QByteArray>
+#include <QMap>
 #include <QPoint>
 #include <QRect>
 #include <QSize>
@@ -35,6 +36,9 @@ public:
     static bool validate(const QByteArray& data);
     static bool validate(const QString& data);
 
+    /// The EDIDs of all outputs in the JSON document @p data by output id.
+    static QMap<int, QByteArray> edidsFromJson(const QByteArray& data);
+
 private:
     static Disman::ScreenPtr screenFromJson(const QMap<QString, QVariant>& data);
     static Disman::OutputPtr outputFromJson(QMap<QString, QVariant> data, bool& primary);
@@ -17,7 +17,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 **************************************************************************/
 #pragma once
 
-#include "filer_controller.h"
+#include "control_store.h"
 #include "filer_helpers.h"
 #include "output_filer.h"
 
@@ -27,7 +27,6 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <types.h>
 
 #include <QObject>
-#include <QStandardPaths>
 #include <QVariantMap>
 
 #include <algorithm>
@@ -41,19 +40,18 @@ namespace Disman
 class Filer
 {
 public:
-    Filer(Disman::ConfigPtr const& config, Filer_controller* controller, std::string suffix = "")
+    Filer(Disman::ConfigPtr const& config, Control_store& store, std::string suffix = "")
         : m_config{config}
-        , m_controller{controller}
+        , m_store{store}
         , m_suffix{suffix}
     {
-        m_dir_path = QString(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
-                             + QStringLiteral("/disman/control/"))
-                         .toStdString();
-        m_read_success = read_file();
+        // Only the records of this config and its outputs are looked up in the store index.
+        m_read_success = store.has_config(key());
+        m_info = store.config_info(key());
 
         for (auto const& [key, output] : config->outputs()) {
             m_output_filers.push_back(
-                std::unique_ptr<Output_filer>(new Output_filer(output, m_controller, m_dir_path)));
+                std::unique_ptr<Output_filer>(new Output_filer(output, m_store)));
         }
     }
 
@@ -330,38 +328,41 @@ public:
                   nullptr);
     }
 
-    std::string dir_path() const
+    /// The key of the control data for @p config in the store.
+    static std::string key(ConfigPtr const& config, std::string const& suffix = "")
     {
-        return m_dir_path + "configs/";
-    }
-
-    std::string file_name() const
-    {
-        auto file_name = m_config->hash().toStdString();
-        if (!m_suffix.empty()) {
-            file_name += "-" + m_suffix;
+        auto key = config->hash().toStdString();
+        if (!suffix.empty()) {
+            key += "-" + suffix;
         }
-        return file_name;
+        return key;
     }
 
-    QFileInfo file_info() const
+    std::string key() const
     {
-        return Filer_helpers::file_info(dir_path(), file_name());
+        return key(m_config, m_suffix);
     }
 
-    bool read_file()
+    /// Sets the values of @p config on the records without writing them to the store yet.
+    void prepare(ConfigPtr const& config)
     {
-        return Filer_helpers::read_file(file_info(), m_info);
+        set_values(config);
+        m_prepared = config;
     }
 
     bool write(ConfigPtr const& config)
     {
-        set_values(config);
+        prepare(config);
+        return write();
+    }
 
-        bool success = true;
+    /// Writes the values set last through @ref prepare to the store.
+    bool write()
+    {
+        assert(m_prepared);
 
         for (auto& output_filer : m_output_filers) {
-            auto const output = config->output(output_filer->output()->id());
+            auto const output = m_prepared->output(output_filer->output()->id());
             if (!output) {
                 // TODO: fallback or reverse clean up?
                 qCDebug(DISMAN_BACKEND)
@@ -372,11 +373,11 @@ public:
             if (output->retention() == Output::Retention::Individual) {
                 continue;
             }
-            success &= output_filer->write_file();
+            output_filer->write();
         }
 
-        success &= Filer_helpers::write_file(m_info, file_info());
-        return success;
+        m_store.set_config_info(key(), m_info);
+        return m_store.save();
     }
 
     static Output::Retention convert_int_to_retention(int val)
@@ -431,15 +432,16 @@ private:
     }
 
     ConfigPtr m_config;
-    Filer_controller* m_controller;
+    Control_store& m_store;
 
     std::vector<std::unique_ptr<Output_filer>> m_output_filers;
 
-    std::string m_dir_path;
     std::string m_suffix;
 
     QVariantMap m_info;
     bool m_read_success{false};
+
+    ConfigPtr m_prepared;
 };
 
 }
@@ -17,15 +17,19 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 **************************************************************************/
 #include "filer_controller.h"
 
+#include "control_store.h"
 #include "device.h"
 #include "filer.h"
 #include "logging.h"
 
+#include "trace.h"
+
 namespace Disman
 {
 
 Filer_controller::Filer_controller(Device* device, QObject* parent)
     : QObject(parent)
+    , m_store{new Control_store}
     , m_device{device}
 {
 }
@@ -34,6 +38,8 @@ Filer_controller::~Filer_controller() = default;
 
 bool Filer_controller::read(ConfigPtr& config)
 {
+    DISMAN_TRACE_SPAN("Filer_controller::read");
+
     if (!m_filer || m_filer->config()->hash() != config->hash()) {
         if (lid_file_exists(config) && m_device->lid_present() && m_device->lid_open()) {
             // Can happen when while lid closed output combination changes or device is shut down.
@@ -53,6 +59,8 @@ bool Filer_controller::read(ConfigPtr& config)
 
 bool Filer_controller::write(ConfigPtr const& config)
 {
+    DISMAN_TRACE_SPAN("Filer_controller::write");
+
     if (m_filer) {
         if (m_filer->config()->hash() != config->hash()) {
             qCWarning(DISMAN_BACKEND)
@@ -63,9 +71,22 @@ bool Filer_controller::write(ConfigPtr const& config)
         reset_filer(config);
     }
 
+    // Records written meanwhile by other processes must not be overwritten with stale data.
+    m_store->sync();
     return m_filer->write(config);
 }
 
+bool Filer_controller::read_detached(ConfigPtr& config)
+{
+    m_store->sync();
+
+    auto const success = Filer(config, *m_store).get_values(config);
+    if (success) {
+        config->set_cause(Config::Cause::file);
+    }
+    return success;
+}
+
 bool Filer_controller::load_lid_file(ConfigPtr& config)
 {
     if (!lid_file_exists(config)) {
@@ -81,29 +102,53 @@ bool Filer_controller::load_lid_file(ConfigPtr& config)
 
 bool Filer_controller::lid_file_exists(ConfigPtr const& config)
 {
-    auto const file_info = Filer(config, this, "open-lid").file_info();
-    return QFile(file_info.filePath()).exists();
+    m_store->sync();
+    return m_store->has_config(Filer::key(config, "open-lid"));
 }
 
 bool Filer_controller::move_lid_file(ConfigPtr const& config)
 {
     assert(lid_file_exists(config));
 
-    auto const file_info = Filer(config, this).file_info();
-    QFile(file_info.filePath()).remove();
-
-    auto const lid_file_info = Filer(config, this, "open-lid").file_info();
-    return QFile::rename(lid_file_info.filePath(), file_info.filePath());
+    if (!m_store->move_config(Filer::key(config, "open-lid"), Filer::key(config))) {
+        return false;
+    }
+    return m_store->save();
 }
 
 bool Filer_controller::save_lid_file(ConfigPtr const& config)
 {
-    return Filer(config, this, "open-lid").write(config);
+    m_store->sync();
+    return Filer(config, *m_store, "open-lid").write(config);
+}
+
+void Filer_controller::prepare_lid_file(ConfigPtr const& config)
+{
+    m_lid_filer.reset(new Filer(config, *m_store, "open-lid"));
+    m_lid_filer->prepare(config);
+}
+
+bool Filer_controller::save_prepared_lid_file()
+{
+    if (!m_lid_filer) {
+        qCWarning(DISMAN_BACKEND) << "No open-lid file prepared.";
+        return false;
+    }
+
+    m_store->sync();
+    auto filer = std::move(m_lid_filer);
+    return filer->write();
+}
+
+void Filer_controller::drop_prepared_lid_file()
+{
+    m_lid_filer.reset();
 }
 
 void Filer_controller::reset_filer(ConfigPtr const& config)
 {
-    m_filer.reset(new Filer(config, this));
+    m_store->sync();
+    m_filer.reset(new Filer(config, *m_store));
 }
 
 }
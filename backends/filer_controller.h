@@ -27,6 +27,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 namespace Disman
 {
+class Control_store;
 class Device;
 class Filer;
 
@@ -58,16 +59,33 @@ public:
      */
     bool write(ConfigPtr const& config);
 
+    /**
+     * Like @ref read but without making @p config the one that is written to on @ref write. For
+     * configs that might be set in the future.
+     */
+    bool read_detached(ConfigPtr& config);
+
+    /// Makes @p config the one that is written to on @ref write without reading it.
+    void reset_filer(ConfigPtr const& config);
+
     bool load_lid_file(ConfigPtr& config);
     bool save_lid_file(ConfigPtr const& config);
 
+    /**
+     * Computes the open-lid record for @p config in advance, so that on lid close it only has to
+     * be written with @ref save_prepared_lid_file.
+     */
+    void prepare_lid_file(ConfigPtr const& config);
+    bool save_prepared_lid_file();
+    void drop_prepared_lid_file();
+
 private:
     bool lid_file_exists(ConfigPtr const& config);
     bool move_lid_file(ConfigPtr const& config);
 
-    void reset_filer(ConfigPtr const& config);
-
+    std::unique_ptr<Control_store> m_store;
     std::unique_ptr<Filer> m_filer;
+    std::unique_ptr<Filer> m_lid_filer;
     Device* m_device;
 };
 
@@ -0,0 +1,191 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "lid_switch.h"
+
+#include "logging.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace Disman
+{
+
+namespace
+{
+
+constexpr size_t bit_array_size(size_t bits)
+{
+    return (bits + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long));
+}
+
+bool test_bit(unsigned long const* array, size_t bit)
+{
+    auto constexpr bits = 8 * sizeof(unsigned long);
+    return array[bit / bits] & (1UL << (bit % bits));
+}
+
+bool query_closed(int fd, bool& closed)
+{
+    unsigned long state[bit_array_size(SW_CNT)] = {};
+    if (ioctl(fd, EVIOCGSW(sizeof(state)), state) < 0) {
+        return false;
+    }
+    closed = test_bit(state, SW_LID);
+    return true;
+}
+
+}
+
+Lid_switch::Lid_switch(QString const& path, QObject* parent)
+    : QObject(parent)
+{
+    if (!path.isEmpty()) {
+        open_device(path, false);
+        return;
+    }
+
+    QDir const dir(QStringLiteral("/dev/input"));
+    auto const nodes = dir.entryList({QStringLiteral("event*")}, QDir::System);
+    for (auto const& node : nodes) {
+        if (open_device(dir.filePath(node), true)) {
+            return;
+        }
+    }
+    qCDebug(DISMAN_BACKEND) << "No readable lid switch among the input devices.";
+}
+
+Lid_switch::~Lid_switch()
+{
+    m_notifier.reset();
+    close_device();
+}
+
+bool Lid_switch::valid() const
+{
+    return m_fd >= 0;
+}
+
+bool Lid_switch::closed() const
+{
+    return m_closed;
+}
+
+bool Lid_switch::open_device(QString const& path, bool probe)
+{
+    auto const fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        if (!probe) {
+            qCWarning(DISMAN_BACKEND) << "Failed to open lid switch" << path << strerror(errno);
+        }
+        return false;
+    }
+
+    unsigned long switches[bit_array_size(SW_CNT)] = {};
+    if (ioctl(fd, EVIOCGBIT(EV_SW, sizeof(switches)), switches) >= 0) {
+        if (!test_bit(switches, SW_LID)) {
+            close(fd);
+            return false;
+        }
+        query_closed(fd, m_closed);
+    } else if (probe) {
+        close(fd);
+        return false;
+    }
+    // An explicitly given node that is no evdev device only delivers events. This allows to test
+    // with a pipe instead of a real input device.
+
+    m_fd = fd;
+    m_notifier.reset(new QSocketNotifier(m_fd, QSocketNotifier::Read));
+    connect(m_notifier.get(), &QSocketNotifier::activated, this, &Lid_switch::read_events);
+
+    qCDebug(DISMAN_BACKEND) << "Reading lid switch from" << path << "- closed:" << m_closed;
+    return true;
+}
+
+void Lid_switch::read_events()
+{
+    input_event events[16];
+
+    while (true) {
+        auto const size = read(m_fd, events, sizeof(events));
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size < 0 && errno == EAGAIN) {
+            return;
+        }
+        if (size <= 0) {
+            qCWarning(DISMAN_BACKEND) << "Lid switch not readable anymore."
+                                      << (size < 0 ? strerror(errno) : "End of file.");
+            close_device();
+            Q_EMIT lost();
+            return;
+        }
+
+        auto const count = static_cast<size_t>(size) / sizeof(input_event);
+        for (size_t i = 0; i < count; i++) {
+            auto const& event = events[i];
+
+            if (event.type == EV_SYN && event.code == SYN_DROPPED) {
+                qCDebug(DISMAN_BACKEND) << "Lid switch events dropped.";
+                m_dropped = true;
+                continue;
+            }
+            if (m_dropped) {
+                if (event.type == EV_SYN && event.code == SYN_REPORT) {
+                    m_dropped = false;
+                    resync();
+                }
+                continue;
+            }
+
+            if (event.type == EV_SW && event.code == SW_LID) {
+                set_closed(event.value != 0);
+            }
+        }
+    }
+}
+
+void Lid_switch::set_closed(bool closed)
+{
+    if (closed != m_closed) {
+        m_closed = closed;
+        Q_EMIT closed_changed(closed);
+    }
+}
+
+void Lid_switch::resync()
+{
+    auto closed = m_closed;
+    if (!query_closed(m_fd, closed)) {
+        qCWarning(DISMAN_BACKEND) << "Failed to query lid switch state." << strerror(errno);
+        return;
+    }
+    set_closed(closed);
+}
+
+void Lid_switch::close_device()
+{
+    if (m_notifier) {
+        // Might be called from its activation.
+        m_notifier->setEnabled(false);
+        m_notifier.release()->deleteLater();
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+}
@@ -0,0 +1,60 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+#include <memory>
+
+class QSocketNotifier;
+
+namespace Disman
+{
+
+/**
+ * Reads the lid state from the SW_LID switch of an evdev input device. Changes arrive as input
+ * events, nothing is polled.
+ *
+ * The device nodes are usually only readable with elevated privileges. When no lid switch can be
+ * opened the object is invalid and the lid state must be taken from somewhere else. The same holds
+ * when the device can not be read anymore, for example because it was removed. The switch then
+ * becomes invalid and emits @ref lost.
+ */
+class Lid_switch : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Searches the input devices for a lid switch, or opens @p path when given.
+    explicit Lid_switch(QString const& path = QString(), QObject* parent = nullptr);
+    ~Lid_switch() override;
+
+    bool valid() const;
+    bool closed() const;
+
+Q_SIGNALS:
+    void closed_changed(bool closed);
+    void lost();
+
+private:
+    bool open_device(QString const& path, bool probe);
+    void read_events();
+    void set_closed(bool closed);
+
+    /// Takes the state from the kernel after events were dropped.
+    void resync();
+    void close_device();
+
+    int m_fd{-1};
+    bool m_closed{false};
+
+    // Events are discarded from a SYN_DROPPED up to the next SYN_REPORT.
+    bool m_dropped{false};
+    std::unique_ptr<QSocketNotifier> m_notifier;
+};
+
+}
@@ -17,8 +17,9 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 **************************************************************************/
 #pragma once
 
-#include "filer_controller.h"
+#include "control_store.h"
 #include "filer_helpers.h"
+#include "logging.h"
 
 #include <output.h>
 #include <types.h>
@@ -34,12 +35,11 @@ namespace Disman
 class Output_filer
 {
 public:
-    Output_filer(OutputPtr output, Filer_controller* controller, std::string const& dir_path)
+    Output_filer(OutputPtr output, Control_store& store)
         : m_output(output)
-        , m_controller(controller)
-        , m_dir_path{dir_path}
+        , m_store{store}
+        , m_info{store.output_info(output->hash())}
     {
-        read_file();
     }
 
     OutputPtr output() const
@@ -172,19 +172,10 @@ public:
         }
     }
 
-    QFileInfo file_info() const
+    /// Hands the data over to the store. It is written to disk together with the config.
+    void write()
     {
-        return Filer_helpers::file_info(m_dir_path + "outputs/", m_output->hash());
-    }
-
-    void read_file()
-    {
-        Filer_helpers::read_file(file_info(), m_info);
-    }
-
-    bool write_file()
-    {
-        return Filer_helpers::write_file(m_info, file_info());
+        m_store.set_output_info(m_output->hash(), m_info);
     }
 
     void get_global_data(OutputPtr& output)
@@ -225,9 +216,8 @@ public:
 
 private:
     OutputPtr m_output;
-    Filer_controller* m_controller;
+    Control_store& m_store;
 
-    std::string m_dir_path;
     QVariantMap m_info;
 };
 
@@ -20,6 +20,9 @@
 #include "qscreenbackend.h"
 #include "qscreenconfig.h"
 #include "qscreenoutput.h"
+#include "qscreen_logging.h"
+
+#include <QGuiApplication>
 
 using namespace Disman;
 
@@ -29,6 +32,13 @@ QScreenBackend::QScreenBackend()
     : Disman::BackendImpl()
     , m_valid(true)
 {
+    if (!qGuiApp) {
+        // For example in dismanctl, which only creates a QCoreApplication.
+        qCWarning(DISMAN_QSCREEN) << "The QScreen backend requires a QGuiApplication.";
+        m_valid = false;
+        return;
+    }
+
     if (s_internalConfig == nullptr) {
         s_internalConfig = new QScreenConfig();
         connect(s_internalConfig, &QScreenConfig::config_changed, this, [this] {
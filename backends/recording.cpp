@@ -0,0 +1,112 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "recording.h"
+
+#include "config.h"
+#include "configserializer_p.h"
+#include "logging.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <array>
+
+namespace Disman::Recording
+{
+
+static std::array<QString, 5> const type_names = {
+    QStringLiteral("initial"),
+    QStringLiteral("change"),
+    QStringLiteral("requested"),
+    QStringLiteral("set"),
+    QStringLiteral("emitted"),
+};
+
+Recorder::Recorder(QString const& path)
+    : m_file(path)
+    , m_start{std::chrono::steady_clock::now()}
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(DISMAN_BACKEND) << "Can not open recording file" << path << m_file.errorString();
+    }
+}
+
+bool Recorder::valid() const
+{
+    return m_file.isOpen();
+}
+
+void Recorder::record(Event_type type, ConfigPtr const& config, bool applied)
+{
+    if (!valid() || !config) {
+        return;
+    }
+
+    auto const time = std::chrono::steady_clock::now() - m_start;
+
+    QJsonObject obj;
+    obj[QLatin1String("time")]
+        = static_cast<qint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+    obj[QLatin1String("type")] = type_names.at(static_cast<size_t>(type));
+    if (type == Event_type::set) {
+        obj[QLatin1String("applied")] = applied;
+    }
+    obj[QLatin1String("config")] = ConfigSerializer::serialize_config(config);
+
+    m_file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    m_file.write("\n");
+    m_file.flush();
+}
+
+std::vector<Event> read(QString const& path)
+{
+    std::vector<Event> events;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(DISMAN_BACKEND) << "Can not open recording file" << path << file.errorString();
+        return events;
+    }
+
+    int line_number = 0;
+    while (!file.atEnd()) {
+        auto const line = file.readLine().trimmed();
+        line_number++;
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QJsonParseError error;
+        auto const obj = QJsonDocument::fromJson(line, &error).object();
+        if (error.error != QJsonParseError::NoError) {
+            qCWarning(DISMAN_BACKEND) << "Skipping invalid line" << line_number << "in recording"
+                                      << path << error.errorString();
+            continue;
+        }
+
+        auto const type_name = obj[QLatin1String("type")].toString();
+        auto const type_it = std::find(type_names.cbegin(), type_names.cend(), type_name);
+        auto const config
+            = ConfigSerializer::deserialize_config(obj[QLatin1String("config")].toObject());
+        if (type_it == type_names.cend() || !config) {
+            qCWarning(DISMAN_BACKEND)
+                << "Skipping invalid event in line" << line_number << "of recording" << path;
+            continue;
+        }
+
+        Event event;
+        event.time = std::chrono::nanoseconds(obj[QLatin1String("time")].toInteger());
+        event.type = static_cast<Event_type>(std::distance(type_names.cbegin(), type_it));
+        event.config = config;
+        event.applied = obj[QLatin1String("applied")].toBool();
+        events.push_back(event);
+    }
+
+    return events;
+}
+
+}
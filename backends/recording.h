@@ -0,0 +1,61 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include "types.h"
+
+#include <QFile>
+#include <QString>
+
+#include <chrono>
+#include <vector>
+
+namespace Disman::Recording
+{
+
+enum class Event_type {
+    /// The windowing system state when the backend was queried for the first time.
+    initial,
+    /// The windowing system reported a changed state.
+    change,
+    /// A client requested a config.
+    requested,
+    /// A config was passed to the windowing system.
+    set,
+    /// The backend emitted a config to its clients.
+    emitted,
+};
+
+struct Event {
+    /// Time since the recording was started.
+    std::chrono::nanoseconds time{0};
+    Event_type type{Event_type::change};
+    ConfigPtr config;
+    /// For set events whether the windowing system was changed by the config.
+    bool applied{false};
+};
+
+/**
+ * Writes the events of a backend session to a file, one JSON object per line. The file is flushed
+ * after every event so a recording stays usable when the backend crashes.
+ */
+class Recorder
+{
+public:
+    explicit Recorder(QString const& path);
+
+    bool valid() const;
+    void record(Event_type type, ConfigPtr const& config, bool applied = false);
+
+private:
+    QFile m_file;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/// Reads back a recording. Lines that can not be parsed are skipped with a warning.
+std::vector<Event> read(QString const& path);
+
+}
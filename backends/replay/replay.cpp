@@ -0,0 +1,172 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "replay.h"
+
+#include "replay_logging.h"
+
+#include "config.h"
+
+#include <algorithm>
+
+using namespace Disman;
+
+Replay::Replay()
+    : BackendImpl()
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &Replay::replay_next);
+    connect(this, &Backend::config_changed, this, &Replay::check_emitted);
+}
+
+Replay::~Replay() = default;
+
+void Replay::init(QVariantMap const& arguments)
+{
+    BackendImpl::init(arguments);
+
+    auto const path = arguments.value(QStringLiteral("RECORDING")).toString();
+    if (path.isEmpty()) {
+        qCWarning(DISMAN_REPLAY) << "No recording to replay given.";
+        return;
+    }
+    if (arguments.contains(QStringLiteral("SPEED"))) {
+        m_speed = arguments.value(QStringLiteral("SPEED")).toDouble();
+    }
+
+    m_events = Recording::read(path);
+
+    // The first state is active right away, all later changes and requests are played back by the
+    // timer.
+    auto const first = std::find_if(m_events.cbegin(), m_events.cend(), [](auto const& event) {
+        return event.type == Recording::Event_type::initial
+            || event.type == Recording::Event_type::change;
+    });
+    if (first == m_events.cend()) {
+        qCWarning(DISMAN_REPLAY) << "Recording" << path << "contains no windowing system state.";
+        return;
+    }
+
+    m_system = first->config;
+    m_time = first->time;
+    m_next = std::distance(m_events.cbegin(), first) + 1;
+
+    qCDebug(DISMAN_REPLAY) << "Replaying" << m_events.size() << "events from" << path
+                           << "with speed" << m_speed;
+    schedule_next();
+}
+
+QString Replay::name() const
+{
+    return QStringLiteral("Replay");
+}
+
+QString Replay::service_name() const
+{
+    return QStringLiteral("org.kwinft.disman.backend.replay");
+}
+
+void Replay::update_config(ConfigPtr& config) const
+{
+    if (!m_system) {
+        return;
+    }
+
+    // Hand out copies so the common backend logic can not change the recorded state.
+    auto const snapshot = m_system->clone();
+    config->setScreen(snapshot->screen());
+    config->set_supported_features(snapshot->supported_features());
+    config->set_tablet_mode_available(snapshot->tablet_mode_available());
+    config->set_tablet_mode_engaged(snapshot->tablet_mode_engaged());
+    config->set_outputs(snapshot->outputs());
+    config->set_primary_output(snapshot->primary_output());
+}
+
+bool Replay::set_config_system(ConfigPtr const& config)
+{
+    auto const expected = take_next(Recording::Event_type::set, m_next_set);
+    if (!expected) {
+        diverged("Config set after the last recorded one");
+        return false;
+    }
+    if (!expected->config->compare(config)) {
+        diverged("Set config differs from the recording");
+    }
+
+    // When the recorded backend changed the windowing system the recording contains the resulting
+    // state as the next change.
+    return expected->applied;
+}
+
+bool Replay::valid() const
+{
+    return m_system != nullptr;
+}
+
+void Replay::schedule_next()
+{
+    auto const next = std::find_if(
+        m_events.cbegin() + m_next, m_events.cend(), [](auto const& event) {
+            return event.type == Recording::Event_type::change
+                || event.type == Recording::Event_type::requested;
+        });
+    if (next == m_events.cend()) {
+        m_next = m_events.size();
+        qCDebug(DISMAN_REPLAY) << "Replay finished with" << m_divergences
+                               << "divergences from the recording.";
+        return;
+    }
+    m_next = std::distance(m_events.cbegin(), next);
+
+    auto delay = std::chrono::milliseconds(0);
+    if (m_speed > 0) {
+        delay = std::chrono::duration_cast<std::chrono::milliseconds>((next->time - m_time)
+                                                                      / m_speed);
+    }
+    m_timer.start(std::max(delay, std::chrono::milliseconds(0)));
+}
+
+void Replay::replay_next()
+{
+    auto const& event = m_events.at(m_next++);
+    m_time = event.time;
+
+    if (event.type == Recording::Event_type::requested) {
+        set_config(event.config->clone());
+    } else {
+        m_system = event.config;
+        handle_config_change();
+    }
+    schedule_next();
+}
+
+void Replay::check_emitted(ConfigPtr const& config)
+{
+    auto const expected = take_next(Recording::Event_type::emitted, m_next_emitted);
+    if (!expected) {
+        diverged("Config emitted after the last recorded one");
+        return;
+    }
+    if (!expected->config->compare(config)) {
+        diverged("Emitted config differs from the recording");
+    }
+}
+
+Recording::Event const* Replay::take_next(Recording::Event_type type, size_t& index)
+{
+    for (; index < m_events.size(); index++) {
+        if (m_events.at(index).type == type) {
+            return &m_events.at(index++);
+        }
+    }
+    return nullptr;
+}
+
+void Replay::diverged(char const* what)
+{
+    m_divergences++;
+    auto const time = std::chrono::duration_cast<std::chrono::milliseconds>(m_time);
+    qCWarning(DISMAN_REPLAY) << what << "at" << time.count() << "ms into the recording.";
+}
@@ -0,0 +1,66 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include "backend_impl.h"
+#include "recording.h"
+
+#include <QTimer>
+
+#include <vector>
+
+/**
+ * Plays back a session recorded from another backend. The recorded windowing system changes and
+ * client requests are fed one after the other into the common backend logic, so the filer and
+ * generator act on them like in the real session. Configs the backend sets or emits are compared
+ * with the recording and deviations are logged as warnings.
+ *
+ * Arguments:
+ * - RECORDING: path of the recording to play back.
+ * - SPEED: factor by which the playback is accelerated. With 0 there are no delays at all.
+ */
+class Replay : public Disman::BackendImpl
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID "org.kwinft.disman.backends.replay")
+
+public:
+    explicit Replay();
+    ~Replay() override;
+
+    void init(QVariantMap const& arguments) override;
+
+    QString name() const override;
+    QString service_name() const override;
+
+    void update_config(Disman::ConfigPtr& config) const override;
+    bool set_config_system(Disman::ConfigPtr const& config) override;
+
+    bool valid() const override;
+
+private:
+    void schedule_next();
+    void replay_next();
+    void check_emitted(Disman::ConfigPtr const& config);
+
+    /// Returns the next event of @p type at or after @p index and moves @p index past it.
+    Disman::Recording::Event const* take_next(Disman::Recording::Event_type type, size_t& index);
+    void diverged(char const* what);
+
+    std::vector<Disman::Recording::Event> m_events;
+    double m_speed{1.};
+
+    // Position of the next change or request to play back.
+    size_t m_next{0};
+    size_t m_next_set{0};
+    size_t m_next_emitted{0};
+
+    // The simulated windowing system state.
+    Disman::ConfigPtr m_system;
+    std::chrono::nanoseconds m_time{0};
+    QTimer m_timer;
+    int m_divergences{0};
+};
@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "synthetic.h"
+
+#include "config.h"
+#include "mode.h"
+#include "output.h"
+#include "screen.h"
+
+#include <memory>
+#include <string>
+
+namespace Disman
+{
+
+ConfigPtr synthetic_config(int output_count, int mode_count)
+{
+    auto config = std::make_shared<Config>(Config::Cause::generated);
+    config->set_supported_features(Config::Feature::Writable | Config::Feature::PrimaryDisplay
+                                   | Config::Feature::PerOutputScaling
+                                   | Config::Feature::OutputReplication);
+
+    auto screen = std::make_shared<Screen>();
+    screen->set_id(1);
+    screen->set_min_size(QSize(8, 8));
+    screen->set_max_size(QSize(65535, 65535));
+    screen->set_max_outputs_count(output_count);
+    config->setScreen(screen);
+
+    double pos_x = 0;
+
+    for (int i = 1; i <= output_count; i++) {
+        auto output = std::make_shared<Output>();
+        auto const name = (i == 1 ? std::string("eDP-") : std::string("DP-")) + std::to_string(i);
+
+        output->set_id(i);
+        output->set_name(name);
+        output->set_description("Synthetic display " + std::to_string(i));
+        output->set_hash(name);
+        output->setType(i == 1 ? Output::Panel : Output::DisplayPort);
+        output->set_physical_size(QSize(600, 340));
+
+        // Spread resolutions and refresh rates so mode selection has some work to do.
+        ModeMap modes;
+        for (int j = 0; j < mode_count; j++) {
+            auto mode = std::make_shared<Mode>();
+            auto const size = QSize(640 + (j / 4) * 32, 480 + (j / 4) * 18);
+            auto const refresh = 50000 + (j % 4) * 20000;
+
+            mode->set_id(std::to_string(j));
+            mode->set_name(std::to_string(size.width()) + "x" + std::to_string(size.height()));
+            mode->set_size(size);
+            mode->set_refresh(refresh);
+            modes.insert({mode->id(), mode});
+        }
+        output->set_modes(modes);
+        output->set_preferred_modes({std::to_string(mode_count / 2)});
+
+        output->set_enabled(true);
+        output->set_position(QPointF(pos_x, 0));
+        pos_x += output->auto_mode()->size().width();
+
+        config->add_output(output);
+    }
+
+    config->set_primary_output(config->output(1));
+    return config;
+}
+
+}
@@ -0,0 +1,19 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include "types.h"
+
+namespace Disman
+{
+
+/**
+ * Creates a config with @p output_count enabled outputs, each offering @p mode_count modes. The
+ * first output is an embedded panel, all others are external displays lined up to its right.
+ */
+ConfigPtr synthetic_config(int output_count, int mode_count);
+
+}
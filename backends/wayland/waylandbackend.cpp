@@ -132,7 +132,15 @@ std::map<int, WaylandOutput*> WaylandBackend::outputMap() const
 
 bool WaylandBackend::valid() const
 {
-    return m_interface && m_interface->is_initialized;
+    if (m_init_state == Init_state::connecting) {
+        return true;
+    }
+    return m_init_state == Init_state::ready && m_interface && m_interface->is_initialized;
+}
+
+bool WaylandBackend::initializing() const
+{
+    return m_init_state == Init_state::connecting;
 }
 
 void WaylandBackend::setScreenOutputs()
@@ -146,11 +154,13 @@ void WaylandBackend::setScreenOutputs()
 
 void WaylandBackend::queryInterface()
 {
+    m_init_timer.start();
+
     QTimer::singleShot(3000, this, [this] {
-        if (m_syncLoop.isRunning()) {
+        if (m_init_state == Init_state::connecting) {
             qCWarning(DISMAN_WAYLAND) << "Connection to Wayland server timed out. Does the "
                                          "compositor support output management?";
-            m_syncLoop.quit();
+            finish_init(false);
         }
     });
 
@@ -158,16 +168,15 @@ void WaylandBackend::queryInterface()
     m_interface = std::make_unique<WaylandInterface>(m_thread);
     connect(m_interface.get(), &WaylandInterface::connectionFailed, this, [this] {
         qCWarning(DISMAN_WAYLAND) << "Backend connection failed.";
-        if (m_syncLoop.isRunning()) {
-            m_syncLoop.quit();
+        if (m_init_state == Init_state::connecting) {
+            finish_init(false);
         }
     });
 
     connect(m_interface.get(), &WaylandInterface::config_changed, this, [this] {
-        if (handle_config_change()) {
-            // When windowing system and us have been synced up quit the sync loop.
-            // That returns the current config.
-            m_syncLoop.quit();
+        if (handle_config_change() && m_init_state == Init_state::connecting) {
+            // Windowing system and us have been synced up for the first time.
+            finish_init(true);
         }
     });
 
@@ -176,6 +185,12 @@ void WaylandBackend::queryInterface()
             &WaylandInterface::outputsChanged,
             this,
             &WaylandBackend::setScreenOutputs);
+}
 
-    m_syncLoop.exec();
+void WaylandBackend::finish_init(bool success)
+{
+    m_init_state = success ? Init_state::ready : Init_state::failed;
+    qCDebug(DISMAN_WAYLAND) << "Initialization" << (success ? "finished" : "failed") << "after"
+                            << m_init_timer.elapsed() << "ms.";
+    Q_EMIT init_finished();
 }
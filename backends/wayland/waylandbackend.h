@@ -21,7 +21,7 @@
 
 #include "../backend_impl.h"
 
-#include <QEventLoop>
+#include <QElapsedTimer>
 #include <QPointer>
 
 #include <memory>
@@ -48,6 +48,7 @@ public:
     QString name() const override;
     QString service_name() const override;
     bool valid() const override;
+    bool initializing() const override;
 
     void update_config(ConfigPtr& config) const override;
     bool set_config_system(Disman::ConfigPtr const& config) override;
@@ -59,6 +60,7 @@ private:
     void setScreenOutputs();
 
     void queryInterface();
+    void finish_init(bool success);
 
     std::unique_ptr<WaylandScreen> m_screen;
     std::unique_ptr<WaylandInterface> m_interface;
@@ -70,7 +72,13 @@ private:
         bool engaged{false};
     } tablet_mode;
 
-    QEventLoop m_syncLoop;
+    // The connection is set up on the interface thread. We are ready once it synced up with us.
+    enum class Init_state {
+        connecting,
+        ready,
+        failed,
+    } m_init_state{Init_state::connecting};
+    QElapsedTimer m_init_timer;
 };
 
 }
@@ -19,6 +19,8 @@
 
 #include "xrandr_logging.h"
 
+#include "trace.h"
+
 #include <QGuiApplication>
 #include <QRect>
 #include <QtGui/private/qtx11extras_p.h>
@@ -144,9 +146,13 @@ bool XCBEventListener::nativeEventFilter(const QByteArray& eventType,
 
     // If this event is not xcb_randr_notify, we don't want it
     if (xEventType == m_randrBase + XCB_RANDR_SCREEN_CHANGE_NOTIFY) {
+        Disman::Trace::start_trace();
+        DISMAN_TRACE_SPAN("XCBEventListener::handleScreenChange");
         handleScreenChange(e);
     }
     if (xEventType == m_randrBase + XCB_RANDR_NOTIFY) {
+        Disman::Trace::start_trace();
+        DISMAN_TRACE_SPAN("XCBEventListener::handleXRandRNotify");
         handleXRandRNotify(e);
     }
 
@@ -27,6 +27,7 @@
 #include "xrandr_logging.h"
 
 #include "config.h"
+#include "log.h"
 #include "output.h"
 
 #include <QRect>
@@ -245,7 +246,7 @@ bool XRandRConfig::applyDismanConfig(const Disman::ConfigPtr& config)
                        << "ModeId:" << currentOutput->currentModeId().c_str()
                        << "Mode: " << currentOutput->currentMode()
                        << "Output: " << currentOutput->id();
-            printConfig(config);
+            DISMAN_LOG_CONFIG(DISMAN_XRANDR, QStringLiteral("Config to apply:"), config);
             printInternalCond();
             continue;
         }
@@ -376,63 +377,6 @@ bool XRandRConfig::applyDismanConfig(const Disman::ConfigPtr& config)
     return true;
 }
 
-void XRandRConfig::printConfig(const ConfigPtr& config) const
-{
-    qCDebug(DISMAN_XRANDR) << "Disman version:" /*<< DISMAN_VERSION*/;
-
-    if (!config) {
-        qCDebug(DISMAN_XRANDR) << "Config is invalid";
-        return;
-    }
-    if (!config->screen()) {
-        qCDebug(DISMAN_XRANDR) << "No screen in the configuration, broken backend";
-        return;
-    }
-
-    qCDebug(DISMAN_XRANDR) << "Screen:"
-                           << "\n"
-                           << "\tmax_size:" << config->screen()->max_size() << "\n"
-                           << "\tmin_size:" << config->screen()->min_size() << "\n"
-                           << "\tcurrent_size:" << config->screen()->current_size();
-
-    qCDebug(DISMAN_XRANDR) << "Primary output:"
-                           << (config->primary_output()
-                                   ? std::to_string(config->primary_output()->id()).c_str()
-                                   : "none");
-
-    auto const outputs = config->outputs();
-    for (auto const& [key, output] : outputs) {
-        qCDebug(DISMAN_XRANDR) << "\n-----------------------------------------------------\n"
-                               << "\n"
-                               << "Id: " << output->id() << "\n"
-                               << "Connector name: " << output->name().c_str() << "\n"
-                               << "Description: " << output->description().c_str() << "\n"
-                               << "Type: " << output->type();
-
-        qCDebug(DISMAN_XRANDR) << "Enabled: " << output->enabled() << "\n"
-                               << "Rotation: " << output->rotation() << "\n"
-                               << "Pos: " << output->position() << "\n"
-                               << "Phyiscal size: " << output->physical_size();
-        if (output->auto_mode()) {
-            qCDebug(DISMAN_XRANDR) << "Size: " << output->auto_mode()->size();
-        }
-
-        qCDebug(DISMAN_XRANDR) << "Mode: " << output->auto_mode()->id().c_str() << "\n"
-                               << "Preferred Mode: " << output->preferred_mode()->id().c_str()
-                               << "\n"
-                               << "Preferred modes:";
-        for (auto const& mode_string : output->preferred_modes()) {
-            qCDebug(DISMAN_XRANDR) << "\t" << mode_string.c_str();
-        }
-
-        qCDebug(DISMAN_XRANDR) << "Modes: ";
-        for (auto const& [key, mode] : output->modes()) {
-            qCDebug(DISMAN_XRANDR) << "\t" << mode->id().c_str() << "  " << mode->name().c_str()
-                                   << " " << mode->size() << " " << mode->refresh();
-        }
-    }
-}
-
 void XRandRConfig::printInternalCond() const
 {
     qCDebug(DISMAN_XRANDR) << "Internal config in xrandr";
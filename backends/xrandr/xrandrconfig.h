@@ -68,7 +68,6 @@ private:
      * We need to print stuff to discover the damn bug
      * where currentMode is null
      */
-    void printConfig(const Disman::ConfigPtr& config) const;
     void printInternalCond() const;
 
     XRandROutput::Map m_outputs;
@@ -0,0 +1,205 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "synthetic_config.h"
+
+#include "backendmanager_p.h"
+#include "getconfigoperation.h"
+
+#include <QtTest>
+
+using namespace Disman;
+
+class BenchConfig : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void clone_data();
+    void clone();
+    void compare_data();
+    void compare();
+    void apply_data();
+    void apply();
+    void hash_data();
+    void hash();
+
+    void best_mode_data();
+    void best_mode();
+    void auto_mode_data();
+    void auto_mode();
+
+    void fake_backend_config();
+    void fake_backend_synthetic_config_data();
+    void fake_backend_synthetic_config();
+};
+
+void BenchConfig::initTestCase()
+{
+    qputenv("DISMAN_LOGGING", "false");
+}
+
+void BenchConfig::clone_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchConfig::clone()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const config = Benchmarks::synthetic_config(outputs, modes);
+
+    QBENCHMARK
+    {
+        auto cloned = config->clone();
+        Q_UNUSED(cloned);
+    }
+}
+
+void BenchConfig::compare_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchConfig::compare()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const config = Benchmarks::synthetic_config(outputs, modes);
+    auto const other = config->clone();
+
+    // Equal configs are the worst case since every output must be checked.
+    QBENCHMARK
+    {
+        QVERIFY(config->compare(other));
+    }
+}
+
+void BenchConfig::apply_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchConfig::apply()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const config = Benchmarks::synthetic_config(outputs, modes);
+    auto const other = Benchmarks::synthetic_config(outputs, modes);
+    other->output(1)->set_enabled(false);
+
+    QBENCHMARK
+    {
+        config->apply(other);
+    }
+}
+
+void BenchConfig::hash_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchConfig::hash()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const config = Benchmarks::synthetic_config(outputs, modes);
+
+    QBENCHMARK
+    {
+        auto hash = config->hash();
+        Q_UNUSED(hash);
+    }
+}
+
+void BenchConfig::best_mode_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchConfig::best_mode()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const output = Benchmarks::synthetic_config(outputs, modes)->output(1);
+
+    QBENCHMARK
+    {
+        QVERIFY(output->best_mode());
+    }
+}
+
+void BenchConfig::auto_mode_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchConfig::auto_mode()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const output = Benchmarks::synthetic_config(outputs, modes)->output(1);
+
+    // Without auto refresh rate the mode must be searched for the best refresh rate.
+    output->set_auto_refresh_rate(false);
+
+    QBENCHMARK
+    {
+        QVERIFY(output->auto_mode());
+    }
+}
+
+void BenchConfig::fake_backend_config()
+{
+    qputenv("DISMAN_IN_PROCESS", "1");
+    qputenv("DISMAN_BACKEND", "fake");
+    qputenv("DISMAN_BACKEND_ARGS", "TEST_DATA=" TEST_DATA "multipleoutput.json");
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+
+    QBENCHMARK
+    {
+        auto op = new GetConfigOperation();
+        QVERIFY(op->exec());
+        QVERIFY(op->config());
+    }
+
+    BackendManager::instance()->shutdown_backend();
+}
+
+void BenchConfig::fake_backend_synthetic_config_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchConfig::fake_backend_synthetic_config()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+
+    qputenv("DISMAN_IN_PROCESS", "1");
+    qputenv("DISMAN_BACKEND", "fake");
+    qputenv("DISMAN_BACKEND_ARGS",
+            QStringLiteral("SYNTHETIC_OUTPUTS=%1;SYNTHETIC_MODES=%2")
+                .arg(outputs)
+                .arg(modes)
+                .toLocal8Bit());
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+
+    QBENCHMARK
+    {
+        auto op = new GetConfigOperation();
+        QVERIFY(op->exec());
+        QCOMPARE(op->config()->outputs().size(), static_cast<size_t>(outputs));
+    }
+
+    BackendManager::instance()->shutdown_backend();
+}
+
+QTEST_GUILESS_MAIN(BenchConfig)
+
+#include "config.moc"
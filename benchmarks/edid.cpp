@@ -0,0 +1,61 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "edid.h"
+
+#include <QtTest>
+
+using namespace Disman;
+
+class BenchEdid : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void parse_data();
+    void parse();
+};
+
+void BenchEdid::initTestCase()
+{
+    qputenv("DISMAN_LOGGING", "false");
+}
+
+void BenchEdid::parse_data()
+{
+    QTest::addColumn<QByteArray>("raw_edid");
+
+    // Same samples as in the EDID autotest: a laptop panel and a Dell monitor with extension block.
+    QTest::addRow("cor") << QByteArray::fromBase64(
+        "AP///////"
+        "wAN8iw0AAAAABwVAQOAHRB4CoPVlFdSjCccUFQAAAABAQEBAQEBAQEBAQEBAQEBEhtWWlAAGTAwIDYAJaQQAAAYEht"
+        "WWlAAGTAwIDYAJaQQAAAYAAAA/gBBVU8KICAgICAgICAgAAAA/gBCMTMzWFcwMyBWNCAKAIc=");
+    QTest::addRow("dell") << QByteArray::fromBase64(
+        "AP///////"
+        "wAQrBbwTExLQQ4WAQOANCB46h7Frk80sSYOUFSlSwCBgKlA0QBxTwEBAQEBAQEBKDyAoHCwI0AwIDYABkQhAAAaAAA"
+        "A/wBGNTI1TTI0NUFLTEwKAAAA/ABERUxMIFUyNDEwCiAgAAAA/"
+        "QA4TB5REQAKICAgICAgAToCAynxUJAFBAMCBxYBHxITFCAVEQYjCQcHZwMMABAAOC2DAQAA4wUDAQI6gBhxOC1AWCx"
+        "FAAZEIQAAHgEdgBhxHBYgWCwlAAZEIQAAngEdAHJR0B4gbihVAAZEIQAAHowK0Iog4C0QED6WAAZEIQAAGAAAAAAAA"
+        "AAAAAAAAAAAAPo=");
+}
+
+void BenchEdid::parse()
+{
+    QFETCH(QByteArray, raw_edid);
+
+    QBENCHMARK
+    {
+        Edid edid(raw_edid);
+        QVERIFY(edid.isValid());
+        auto hash = edid.hash();
+        Q_UNUSED(hash);
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchEdid)
+
+#include "edid.moc"
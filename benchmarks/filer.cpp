@@ -0,0 +1,131 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "synthetic_config.h"
+
+#include "filer.h"
+
+#include <QStandardPaths>
+#include <QtTest>
+
+using namespace Disman;
+
+class BenchFiler : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void write_data();
+    void write();
+    void read_data();
+    void read();
+    void load_data();
+    void load();
+
+private:
+    QString control_dir() const;
+};
+
+void BenchFiler::initTestCase()
+{
+    qputenv("DISMAN_LOGGING", "false");
+
+    // Keeps the control files of the user untouched.
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(control_dir()).removeRecursively();
+}
+
+void BenchFiler::cleanupTestCase()
+{
+    QDir(control_dir()).removeRecursively();
+}
+
+QString BenchFiler::control_dir() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
+        + QStringLiteral("/disman/control/");
+}
+
+void BenchFiler::write_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchFiler::write()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const config = Benchmarks::synthetic_config(outputs, modes);
+
+    Control_store store(control_dir());
+
+    QBENCHMARK
+    {
+        Filer filer(config, store);
+        QVERIFY(filer.write(config));
+    }
+}
+
+void BenchFiler::read_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchFiler::read()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto config = Benchmarks::synthetic_config(outputs, modes);
+
+    Control_store store(control_dir());
+    Filer(config, store).write(config);
+
+    QBENCHMARK
+    {
+        Filer filer(config, store);
+        QVERIFY(filer.get_values(config));
+    }
+}
+
+void BenchFiler::load_data()
+{
+    QTest::addColumn<int>("configs");
+
+    for (auto configs : {10, 100, 500}) {
+        QTest::addRow("%d configs", configs) << configs;
+    }
+}
+
+void BenchFiler::load()
+{
+    QFETCH(int, configs);
+    QDir(control_dir()).removeRecursively();
+
+    // Profiles that grew over a long time, each with a different combination of outputs.
+    {
+        Control_store store(control_dir());
+        for (int i = 0; i < configs; i++) {
+            auto config = Benchmarks::synthetic_config(1 + i % 4, 10);
+            auto outputs = config->outputs();
+            for (auto& [key, output] : outputs) {
+                output->set_hash_raw(std::to_string(i) + "-" + std::to_string(key));
+            }
+            Filer(config, store).write(config);
+        }
+    }
+
+    QBENCHMARK
+    {
+        Control_store store(control_dir());
+        Q_UNUSED(store);
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchFiler)
+
+#include "filer.moc"
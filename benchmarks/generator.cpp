@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "synthetic_config.h"
+
+#include "generator.h"
+
+#include <QtTest>
+
+using namespace Disman;
+
+class BenchGenerator : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void optimize_data();
+    void optimize();
+    void extend_data();
+    void extend();
+    void replicate_data();
+    void replicate();
+};
+
+void BenchGenerator::initTestCase()
+{
+    qputenv("DISMAN_LOGGING", "false");
+}
+
+void BenchGenerator::optimize_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchGenerator::optimize()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const config = Benchmarks::synthetic_config(outputs, modes);
+
+    QBENCHMARK
+    {
+        Generator generator(config);
+        generator.optimize();
+    }
+}
+
+void BenchGenerator::extend_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchGenerator::extend()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const config = Benchmarks::synthetic_config(outputs, modes);
+
+    QBENCHMARK
+    {
+        Generator generator(config);
+        generator.extend(Generator::Extend_direction::right);
+    }
+}
+
+void BenchGenerator::replicate_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchGenerator::replicate()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const config = Benchmarks::synthetic_config(outputs, modes);
+
+    QBENCHMARK
+    {
+        Generator generator(config);
+        generator.replicate();
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchGenerator)
+
+#include "generator.moc"
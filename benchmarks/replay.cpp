@@ -0,0 +1,111 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "synthetic_config.h"
+
+#include "backend.h"
+#include "backendmanager_p.h"
+#include "recording.h"
+
+#include <QEventLoop>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+using namespace Disman;
+
+class BenchReplay : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void dock_flapping_data();
+    void dock_flapping();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+void BenchReplay::initTestCase()
+{
+    qputenv("DISMAN_LOGGING", "false");
+    qputenv("DISMAN_IN_PROCESS", "1");
+    qputenv("DISMAN_BACKEND", "replay");
+
+    // Keeps the control files of the user untouched.
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+}
+
+void BenchReplay::cleanup()
+{
+    BackendManager::instance()->shutdown_backend();
+}
+
+void BenchReplay::dock_flapping_data()
+{
+    QTest::addColumn<int>("outputs");
+    QTest::addColumn<int>("modes");
+
+    for (auto outputs : {2, 4, 8}) {
+        for (auto modes : {10, 100}) {
+            QTest::addRow("%d outputs, %d modes", outputs, modes) << outputs << modes;
+        }
+    }
+}
+
+void BenchReplay::dock_flapping()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+
+    // A docking station with the external outputs connecting and disconnecting repeatedly.
+    auto system_state = [modes](int count) {
+        auto config = Benchmarks::synthetic_config(count, modes);
+        config->set_cause(Config::Cause::unknown);
+        return config;
+    };
+
+    auto const path = m_dir.filePath(QString::fromLatin1(QTest::currentDataTag()));
+    int const flaps = 20;
+    {
+        Recording::Recorder recorder(path);
+        QVERIFY(recorder.valid());
+        recorder.record(Recording::Event_type::initial, system_state(1));
+        for (int i = 0; i < flaps; i++) {
+            recorder.record(Recording::Event_type::change, system_state(outputs));
+            recorder.record(Recording::Event_type::change, system_state(1));
+        }
+    }
+    qputenv("DISMAN_BACKEND_ARGS", QByteArray("RECORDING=") + path.toUtf8() + ";SPEED=0");
+    BackendManager::instance()->set_method(BackendManager::InProcess);
+
+    QBENCHMARK
+    {
+        BackendManager::instance()->shutdown_backend();
+        auto backend
+            = BackendManager::instance()->load_backend_in_process(QStringLiteral("replay"));
+        QVERIFY(backend);
+
+        // Polling would dominate the measurement, so wait on a loop that ends with the replay.
+        QEventLoop loop;
+        int emitted = 0;
+        connect(backend, &Backend::config_changed, &loop, [&] {
+            if (++emitted == 2 * flaps) {
+                loop.quit();
+            }
+        });
+        QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+        loop.exec();
+        QCOMPARE(emitted, 2 * flaps);
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchReplay)
+
+#include "replay.moc"
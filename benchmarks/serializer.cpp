@@ -0,0 +1,115 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "synthetic_config.h"
+
+#include "configserializer_p.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QtTest>
+
+using namespace Disman;
+
+/**
+ * Receives a serialized config over D-Bus. Clients deserialize maps whose nested values are
+ * QDBusArguments. We get such a map by calling this object on our own bus connection. QtDBus
+ * marshalls and demarshalls local calls with complex arguments like it does for remote ones.
+ */
+class Receiver : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kwinft.disman.benchmark")
+
+public:
+    QVariantMap received;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE void receive(QVariantMap const& map)
+    {
+        received = map;
+    }
+};
+
+class BenchSerializer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void serialize_data();
+    void serialize();
+    void deserialize_data();
+    void deserialize();
+
+private:
+    QVariantMap send_over_dbus(QVariantMap const& map);
+
+    Receiver m_receiver;
+};
+
+void BenchSerializer::initTestCase()
+{
+    qputenv("DISMAN_LOGGING", "false");
+
+    QVERIFY(QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/receiver"), &m_receiver, QDBusConnection::ExportScriptableSlots));
+}
+
+QVariantMap BenchSerializer::send_over_dbus(QVariantMap const& map)
+{
+    auto bus = QDBusConnection::sessionBus();
+    auto call = QDBusMessage::createMethodCall(bus.baseService(),
+                                               QStringLiteral("/receiver"),
+                                               QStringLiteral("org.kwinft.disman.benchmark"),
+                                               QStringLiteral("receive"));
+    call.setArguments({map});
+    bus.call(call);
+    return m_receiver.received;
+}
+
+void BenchSerializer::serialize_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchSerializer::serialize()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const config = Benchmarks::synthetic_config(outputs, modes);
+
+    // Includes the conversion to a variant map as done for every D-Bus message.
+    QBENCHMARK
+    {
+        auto const map = ConfigSerializer::serialize_config(config).toVariantMap();
+        QVERIFY(!map.isEmpty());
+    }
+}
+
+void BenchSerializer::deserialize_data()
+{
+    Benchmarks::add_synthetic_config_data();
+}
+
+void BenchSerializer::deserialize()
+{
+    QFETCH(int, outputs);
+    QFETCH(int, modes);
+    auto const config = Benchmarks::synthetic_config(outputs, modes);
+    auto const map = send_over_dbus(ConfigSerializer::serialize_config(config).toVariantMap());
+    QVERIFY(!map.isEmpty());
+
+    QBENCHMARK
+    {
+        auto const deserialized = ConfigSerializer::deserialize_config(map);
+        QVERIFY(deserialized);
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchSerializer)
+
+#include "serializer.moc"
@@ -0,0 +1,110 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include <QtTest>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <vector>
+
+extern char** environ;
+
+class BenchStartup : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void dismanctl_data();
+    void dismanctl();
+
+    void dismanctl_rss_data();
+    void dismanctl_rss();
+
+private:
+    /// Runs dismanctl until it quits and returns its peak resident set size in KiB.
+    long run_dismanctl(bool in_process);
+};
+
+long BenchStartup::run_dismanctl(bool in_process)
+{
+    // The environment is prepared before forking, the child only execs.
+    std::vector<QByteArray> env_storage;
+    for (auto var = environ; *var; var++) {
+        QByteArray const entry(*var);
+        if (entry.startsWith("DISMAN_IN_PROCESS=") || entry.startsWith("QT_QPA_PLATFORM=")) {
+            continue;
+        }
+        env_storage.push_back(entry);
+    }
+    if (in_process) {
+        // The offscreen platform needs no display server but otherwise loads like any other.
+        env_storage.push_back("DISMAN_IN_PROCESS=1");
+        env_storage.push_back("QT_QPA_PLATFORM=offscreen");
+    }
+
+    std::vector<char*> env;
+    for (auto& entry : env_storage) {
+        env.push_back(entry.data());
+    }
+    env.push_back(nullptr);
+
+    auto const pid = fork();
+    if (pid == 0) {
+        auto const null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        execle(DISMANCTL_PATH, "dismanctl", "--help", nullptr, env.data());
+        _exit(127);
+    }
+    if (pid < 0) {
+        return -1;
+    }
+
+    int status;
+    rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status)
+        || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    return usage.ru_maxrss;
+}
+
+void BenchStartup::dismanctl_data()
+{
+    QTest::addColumn<bool>("in_process");
+
+    QTest::addRow("core application") << false;
+    QTest::addRow("gui application") << true;
+}
+
+void BenchStartup::dismanctl()
+{
+    QFETCH(bool, in_process);
+
+    QBENCHMARK
+    {
+        QVERIFY(run_dismanctl(in_process) > 0);
+    }
+}
+
+void BenchStartup::dismanctl_rss_data()
+{
+    dismanctl_data();
+}
+
+void BenchStartup::dismanctl_rss()
+{
+    QFETCH(bool, in_process);
+
+    auto const rss = run_dismanctl(in_process);
+    QVERIFY(rss > 0);
+    QTest::setBenchmarkResult(rss * 1024., QTest::BytesAllocated);
+}
+
+QTEST_GUILESS_MAIN(BenchStartup)
+
+#include "startup.moc"
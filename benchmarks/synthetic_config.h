@@ -0,0 +1,36 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include "config.h"
+#include "mode.h"
+#include "output.h"
+#include "screen.h"
+#include "synthetic.h"
+
+#include <QTest>
+
+namespace Disman::Benchmarks
+{
+
+using Disman::synthetic_config;
+
+/**
+ * Adds the data columns "outputs" and "modes" covering 1 to 32 outputs and 10 to 500 modes.
+ */
+inline void add_synthetic_config_data()
+{
+    QTest::addColumn<int>("outputs");
+    QTest::addColumn<int>("modes");
+
+    for (auto outputs : {1, 2, 4, 8, 16, 32}) {
+        for (auto modes : {10, 50, 100, 500}) {
+            QTest::addRow("%d outputs, %d modes", outputs, modes) << outputs << modes;
+        }
+    }
+}
+
+}
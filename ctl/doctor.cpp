@@ -8,6 +8,10 @@
 #include "watcher.h"
 
 #include <QCommandLineParser>
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QRectF>
@@ -17,6 +21,7 @@
 #include "configoperation.h"
 #include "getconfigoperation.h"
 #include "log.h"
+#include "metrics.h"
 #include "setconfigoperation.h"
 
 Q_LOGGING_CATEGORY(DISMAN_CTL, "disman.ctl")
@@ -53,6 +58,9 @@ Doctor::Doctor(QCommandLineParser* parser, QObject* parent)
     if (m_parser->isSet(QStringLiteral("info"))) {
         showBackends();
     }
+    if (m_parser->isSet(QStringLiteral("stats"))) {
+        showStats();
+    }
     if (parser->isSet(QStringLiteral("json")) || parser->isSet(QStringLiteral("outputs"))
         || parser->isSet(QStringLiteral("watch")) || !m_parser->positionalArguments().isEmpty()) {
 
@@ -113,6 +121,88 @@ void Doctor::showBackends() const
     cout << Qt::endl;
 }
 
+static QVariantMap to_map(QVariant const& var)
+{
+    if (var.canConvert<QDBusArgument>()) {
+        return qdbus_cast<QVariantMap>(var.value<QDBusArgument>());
+    }
+    return var.toMap();
+}
+
+static QVariantList to_list(QVariant const& var)
+{
+    if (var.canConvert<QDBusArgument>()) {
+        return qdbus_cast<QVariantList>(var.value<QDBusArgument>());
+    }
+    return var.toList();
+}
+
+static QString format_us(double us)
+{
+    if (us < 1000) {
+        return QString::number(us, 'f', 0) + QStringLiteral(" µs");
+    }
+    return QString::number(us / 1000, 'f', 2) + QStringLiteral(" ms");
+}
+
+void Doctor::showStats() const
+{
+    auto const service = BackendManager::service_name();
+    auto bus = QDBusConnection::sessionBus();
+
+    // Do not let the query activate the service. A fresh instance has no interesting numbers.
+    if (!bus.interface()->isServiceRegistered(service)) {
+        cerr << "The Disman service is not running." << Qt::endl;
+        return;
+    }
+
+    auto const msg = QDBusMessage::createMethodCall(service,
+                                                    QStringLiteral("/"),
+                                                    QStringLiteral("org.kwinft.disman.metrics"),
+                                                    QStringLiteral("stats"));
+    auto const reply = bus.call(msg);
+    if (reply.type() != QDBusMessage::ReplyMessage || reply.arguments().isEmpty()) {
+        cerr << "Failed to query statistics: " << reply.errorMessage() << Qt::endl;
+        return;
+    }
+
+    auto const stats = to_map(reply.arguments().first());
+    cout << "Backend: " << green << stats.value(QStringLiteral("backend")).toString() << cr
+         << Qt::endl;
+
+    cout << "Counters:" << Qt::endl;
+    auto const counters = to_map(stats.value(QStringLiteral("counters")));
+    for (auto it = counters.cbegin(); it != counters.cend(); ++it) {
+        cout << "  * " << qSetFieldWidth(28) << Qt::left << it.key() << qSetFieldWidth(0) << ": "
+             << it.value().toULongLong() << Qt::endl;
+    }
+
+    cout << "Durations:" << Qt::endl;
+    auto const histograms = to_map(stats.value(QStringLiteral("histograms")));
+    for (auto it = histograms.cbegin(); it != histograms.cend(); ++it) {
+        auto histogram = to_map(it.value());
+        auto const count = histogram.value(QStringLiteral("count")).toULongLong();
+        if (!count) {
+            continue;
+        }
+        histogram.insert(QStringLiteral("buckets"),
+                         to_list(histogram.value(QStringLiteral("buckets"))));
+
+        // Percentiles are upper bounds of the power-of-two buckets.
+        auto percentile = [&histogram](double p) {
+            return static_cast<double>(Disman::Metrics::percentile_us(histogram, p));
+        };
+
+        cout << "  * " << qSetFieldWidth(28) << Qt::left << it.key() << qSetFieldWidth(0) << ": "
+             << count << " times, mean "
+             << format_us(histogram.value(QStringLiteral("sum-us")).toDouble() / count)
+             << ", p50 <= " << format_us(percentile(0.5)) << ", p99 <= "
+             << format_us(percentile(0.99)) << ", max "
+             << format_us(histogram.value(QStringLiteral("max-us")).toDouble()) << Qt::endl;
+    }
+    cout << Qt::endl;
+}
+
 void Doctor::parsePositionalArgs()
 {
     auto const& args = m_parser->positionalArguments();
@@ -33,6 +33,7 @@ public:
     void configReceived(Disman::ConfigOperation* op);
 
     void showBackends() const;
+    void showStats() const;
     static void showOutputs(Disman::ConfigPtr const& config);
     void showJson() const;
 
@@ -9,6 +9,8 @@
 #include <QCommandLineParser>
 #include <QGuiApplication>
 
+#include <memory>
+
 /** Usage example:
  * dismanctl --set output.0.disable output.1.mode.1 output.1.enable"
  *
@@ -71,7 +73,15 @@ int main(int argc, char** argv)
         "Multiple settings are passed in order to have dismanctl apply these settings in one "
         "go.\n");
 
-    QGuiApplication app(argc, argv);
+    // Talking to the service needs no GUI. Only backends loaded in-process might, for example the
+    // QScreen and XRandR ones, and the platform plugin takes long to load.
+    std::unique_ptr<QCoreApplication> app;
+    auto const in_process = qgetenv("DISMAN_IN_PROCESS").toLower();
+    if (!in_process.isEmpty() && in_process != "0" && in_process != "false") {
+        app.reset(new QGuiApplication(argc, argv));
+    } else {
+        app.reset(new QCoreApplication(argc, argv));
+    }
 
     QCommandLineOption info
         = QCommandLineOption(QStringList() << QStringLiteral("i") << QStringLiteral("info"),
@@ -86,6 +96,9 @@ int main(int argc, char** argv)
         = QCommandLineOption(QStringList() << QStringLiteral("l") << QStringLiteral("log"),
                              QStringLiteral("Write a comment to the log file"),
                              QStringLiteral("comment"));
+    QCommandLineOption stats = QCommandLineOption(
+        QStringList() << QStringLiteral("s") << QStringLiteral("stats"),
+        QStringLiteral("Show counters and durations collected by the Disman service"));
     QCommandLineOption watch
         = QCommandLineOption(QStringList() << QStringLiteral("w") << QStringLiteral("watch"),
                              QStringLiteral("Watch for changes and print them to stdout."));
@@ -101,10 +114,11 @@ int main(int argc, char** argv)
     parser.addOption(json);
     parser.addOption(outputs);
     parser.addOption(log);
+    parser.addOption(stats);
     parser.addOption(watch);
-    parser.process(app);
+    parser.process(*app);
 
     Disman::Ctl::Doctor server(&parser);
 
-    return app.exec();
+    return app->exec();
 }
@@ -14,4 +14,9 @@ Backend::Backend(QObject* parent)
 {
 }
 
+bool Backend::initializing() const
+{
+    return false;
+}
+
 }
@@ -61,8 +61,11 @@ public:
      * Apply a config object to the system.
      *
      * @param config Configuration to apply
+     * @return the config as it was committed, possibly adjusted by the backend. Null when the
+     *         windowing system applies the config asynchronously. The committed config is then
+     *         emitted with config_changed once the windowing system confirmed it.
      */
-    virtual void set_config(const Disman::ConfigPtr& config) = 0;
+    virtual Disman::ConfigPtr set_config(const Disman::ConfigPtr& config) = 0;
 
     /**
      * Returns whether the backend is in valid state.
@@ -72,7 +75,21 @@ public:
      */
     virtual bool valid() const = 0;
 
+    /**
+     * Returns whether the backend is still connecting to the windowing system. Until it emits
+     * init_finished config() and set_config() must not be called.
+     *
+     * Backends that initialize synchronously return false, which is the default.
+     */
+    virtual bool initializing() const;
+
 Q_SIGNALS:
+    /**
+     * Emitted once by backends that initialize asynchronously when they are done. On failure
+     * valid() returns false afterwards.
+     */
+    void init_finished();
+
     /**
      * Emitted when backend detects a change in configuration
      *
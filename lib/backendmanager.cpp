@@ -28,14 +28,14 @@
 #include "getconfigoperation.h"
 #include "log.h"
 
+#include <QCoreApplication>
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
 #include <QDBusPendingCall>
 #include <QDBusPendingCallWatcher>
 #include <QDBusPendingReply>
-#include <QGuiApplication>
+#include <QElapsedTimer>
 #include <QStandardPaths>
-#include <QThread>
 
 #include <memory>
 
@@ -83,6 +83,22 @@ BackendManager::BackendManager()
 
     // TODO(romangg): fallback to in-process when dbus not available?
 
+    // Backend calls go over a direct connection to the service by default. Setting
+    // DISMAN_PEER_TO_PEER to false forces all traffic over the session bus.
+    auto const peer_to_peer = qgetenv("DISMAN_PEER_TO_PEER");
+    if (!peer_to_peer.isEmpty()) {
+        const QByteArrayList falses({QByteArray("0"), QByteArray("false")});
+        m_use_peer_connection = !falses.contains(peer_to_peer.toLower());
+    }
+
+    // Completes a shutdown once the service left the bus.
+    m_shutdown_watcher.setConnection(QDBusConnection::sessionBus());
+    m_shutdown_watcher.setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    connect(&m_shutdown_watcher,
+            &QDBusServiceWatcher::serviceUnregistered,
+            this,
+            &BackendManager::complete_shutdown);
+
     init_method();
 }
 
@@ -108,6 +124,15 @@ void BackendManager::set_method(BackendManager::Method m)
     if (mMethod == m) {
         return;
     }
+    if (mRequestsCounter > 0) {
+        // The shutdown can not wait for them, afterwards there is no backend of the old method
+        // anymore. So they fail now, while their receivers still expect the old method.
+        qCWarning(DISMAN) << "Changing the backend method with" << mRequestsCounter
+                          << "pending backend requests.";
+        mRequestsCounter = 0;
+        m_shutdown_pending = false;
+        Q_EMIT backend_ready(nullptr);
+    }
     shutdown_backend();
     mMethod = m;
     init_method();
@@ -236,6 +261,10 @@ Disman::Backend* BackendManager::load_backend_plugin(QPluginLoader* loader,
     auto backend = qobject_cast<Disman::Backend*>(instance);
     if (backend) {
         backend->init(arguments);
+        if (backend->initializing()) {
+            qCDebug(DISMAN) << "Initializing backend asynchronously:" << backend->name();
+            return backend;
+        }
         if (!backend->valid()) {
             qCDebug(DISMAN) << "Skipping" << backend->name() << "backend";
             delete backend;
@@ -250,6 +279,46 @@ Disman::Backend* BackendManager::load_backend_plugin(QPluginLoader* loader,
     return nullptr;
 }
 
+QString BackendManager::instance_name()
+{
+    auto name = QString::fromLocal8Bit(qgetenv("DISMAN_INSTANCE"));
+
+    // Only characters valid in bus names and file names, for example ':99' becomes '_99'.
+    for (auto& c : name) {
+        if (!c.isLetterOrNumber() || c.unicode() > 127) {
+            c = QLatin1Char('_');
+        }
+    }
+    return name;
+}
+
+QString BackendManager::service_name()
+{
+    auto const instance = instance_name();
+    if (instance.isEmpty()) {
+        return QStringLiteral("org.kwinft.disman");
+    }
+    // Bus name elements must not start with a digit.
+    return QStringLiteral("org.kwinft.disman.instance_") + instance;
+}
+
+/// Backend arguments from DISMAN_BACKEND_ARGS as key=value pairs separated by semicolons.
+static QVariantMap backend_arguments()
+{
+    QVariantMap arguments;
+
+    auto const args = QString::fromLocal8Bit(qgetenv("DISMAN_BACKEND_ARGS"));
+    for (auto const& arg : args.split(QLatin1Char(';'), Qt::SkipEmptyParts)) {
+        auto const pos = arg.indexOf(QLatin1Char('='));
+        if (pos == -1) {
+            continue;
+        }
+        arguments.insert(arg.left(pos), arg.mid(pos + 1));
+    }
+
+    return arguments;
+}
+
 Disman::Backend* BackendManager::load_backend_in_process(const QString& name)
 {
     Q_ASSERT(mMethod == InProcess);
@@ -269,12 +338,7 @@ Disman::Backend* BackendManager::load_backend_in_process(const QString& name)
     if (mLoader == nullptr) {
         mLoader = new QPluginLoader(this);
     }
-    auto test_data_equals = QStringLiteral("TEST_DATA=");
-    QVariantMap arguments;
-    auto beargs = QString::fromLocal8Bit(qgetenv("DISMAN_BACKEND_ARGS"));
-    if (beargs.startsWith(test_data_equals)) {
-        arguments[QStringLiteral("TEST_DATA")] = beargs.remove(test_data_equals);
-    }
+    auto const arguments = backend_arguments();
     auto backend = BackendManager::load_backend_plugin(mLoader, name, arguments);
     if (!backend) {
         return nullptr;
@@ -282,7 +346,32 @@ Disman::Backend* BackendManager::load_backend_in_process(const QString& name)
     // qCDebug(DISMAN) << "Connecting ConfigMonitor to backend.";
     ConfigMonitor::instance()->connect_in_process_backend(backend);
     m_inProcessBackend = {backend, arguments};
-    set_config(backend->config());
+
+    if (!backend->initializing()) {
+        set_config(backend->config());
+        return backend;
+    }
+
+    // Operations wait for the initialization themselves. An invalid backend is only dropped on
+    // the next event cycle, so their handlers can still query it.
+    connect(
+        backend,
+        &Backend::init_finished,
+        this,
+        [this, backend] {
+            if (m_inProcessBackend.first != backend) {
+                return;
+            }
+            if (!backend->valid()) {
+                qCDebug(DISMAN) << "Skipping" << backend->name() << "backend";
+                m_inProcessBackend.first = nullptr;
+                m_inProcessBackend.second.clear();
+                delete backend;
+                return;
+            }
+            set_config(backend->config());
+        },
+        static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::SingleShotConnection));
     return backend;
 }
 
@@ -301,29 +390,24 @@ void BackendManager::request_backend()
     }
     ++mRequestsCounter;
 
-    const QByteArray args = qgetenv("DISMAN_BACKEND_ARGS");
-    QVariantMap arguments;
-    if (!args.isEmpty()) {
-        QList<QByteArray> arglist = args.split(';');
-        Q_FOREACH (const QByteArray& arg, arglist) {
-            const int pos = arg.indexOf('=');
-            if (pos == -1) {
-                continue;
-            }
-            arguments.insert(QString::fromUtf8(arg.left(pos)), arg.mid(pos + 1));
-        }
+    if (mShuttingDown) {
+        // The old service would still answer. Started once it left the bus.
+        return;
     }
-
-    start_backend(QString::fromLatin1(qgetenv("DISMAN_BACKEND")), arguments);
+    start_backend(QString::fromLatin1(qgetenv("DISMAN_BACKEND")), backend_arguments());
 }
 
 void BackendManager::emit_backend_ready()
 {
-    Q_ASSERT(mMethod == OutOfProcess);
+    if (mMethod != OutOfProcess || mRequestsCounter == 0) {
+        // The requests were failed when the method changed.
+        return;
+    }
     Q_EMIT backend_ready(mInterface);
     --mRequestsCounter;
-    if (mShutdownLoop.isRunning()) {
-        mShutdownLoop.quit();
+    if (m_shutdown_pending && mRequestsCounter == 0) {
+        m_shutdown_pending = false;
+        finish_shutdown();
     }
 }
 
@@ -335,7 +419,7 @@ void BackendManager::start_backend(const QString& backend, const QVariantMap& ar
     //   b) if the launcher is already running it will make sure it's running with
     //      the same backend as the one we requested and send an error otherwise
     QDBusConnection conn = QDBusConnection::sessionBus();
-    QDBusMessage call = QDBusMessage::createMethodCall(QStringLiteral("org.kwinft.disman"),
+    QDBusMessage call = QDBusMessage::createMethodCall(service_name(),
                                                        QStringLiteral("/"),
                                                        QStringLiteral("org.kwinft.disman"),
                                                        QStringLiteral("requestBackend"));
@@ -350,8 +434,10 @@ void BackendManager::start_backend(const QString& backend, const QVariantMap& ar
 
 void BackendManager::on_backend_request_done(QDBusPendingCallWatcher* watcher)
 {
-    Q_ASSERT(mMethod == OutOfProcess);
     watcher->deleteLater();
+    if (mMethod != OutOfProcess) {
+        return;
+    }
     QDBusPendingReply<bool> reply = *watcher;
     // Most probably we requested an explicit backend that is different than the
     // one already loaded in the launcher
@@ -374,13 +460,64 @@ void BackendManager::on_backend_request_done(QDBusPendingCallWatcher* watcher)
     }
 
     // The launcher has successfully loaded the backend we wanted and registered
-    // it to DBus (hopefuly), let's try to get an interface for the backend.
+    // it to DBus (hopefuly). Now ask it for a direct connection so we don't need to
+    // route all further calls through the bus daemon.
     if (mInterface) {
         invalidate_interface();
     }
-    mInterface = new org::kwinft::disman::backend(QStringLiteral("org.kwinft.disman"),
-                                                  QStringLiteral("/backend"),
-                                                  QDBusConnection::sessionBus());
+    if (!m_use_peer_connection) {
+        connect_interface(QDBusConnection::sessionBus());
+        return;
+    }
+
+    QDBusMessage call = QDBusMessage::createMethodCall(service_name(),
+                                                       QStringLiteral("/"),
+                                                       QStringLiteral("org.kwinft.disman"),
+                                                       QStringLiteral("peerAddress"));
+    QDBusPendingCall pending = QDBusConnection::sessionBus().asyncCall(call);
+    auto peer_watcher = new QDBusPendingCallWatcher(pending);
+    connect(peer_watcher,
+            &QDBusPendingCallWatcher::finished,
+            this,
+            &BackendManager::on_peer_address_received);
+}
+
+void BackendManager::on_peer_address_received(QDBusPendingCallWatcher* watcher)
+{
+    watcher->deleteLater();
+    if (mMethod != OutOfProcess) {
+        return;
+    }
+    QDBusPendingReply<QString> reply = *watcher;
+
+    // An older launcher or one that failed to set up its server. We can still use the bus.
+    if (reply.isError() || reply.value().isEmpty()) {
+        qCDebug(DISMAN) << "No peer-to-peer connection offered, using the session bus.";
+        connect_interface(QDBusConnection::sessionBus());
+        return;
+    }
+
+    m_peer_connection = QStringLiteral("disman-backend-peer");
+
+    auto connection = QDBusConnection::connectToPeer(reply.value(), m_peer_connection);
+    if (!connection.isConnected()) {
+        qCWarning(DISMAN) << "Failed to connect to backend peer at" << reply.value() << ":"
+                          << connection.lastError().message() << "Using the session bus instead.";
+        QDBusConnection::disconnectFromPeer(m_peer_connection);
+        m_peer_connection.clear();
+        connect_interface(QDBusConnection::sessionBus());
+        return;
+    }
+
+    connect_interface(connection);
+}
+
+void BackendManager::connect_interface(QDBusConnection const& connection)
+{
+    // Peer-to-peer connections have no bus names.
+    auto const service = m_peer_connection.isEmpty() ? service_name() : QString();
+    mInterface
+        = new org::kwinft::disman::backend(service, QStringLiteral("/backend"), connection);
     if (!mInterface->isValid()) {
         qCWarning(DISMAN) << "Backend successfully requested, but we failed to obtain a valid DBus "
                              "interface for it";
@@ -390,11 +527,14 @@ void BackendManager::on_backend_request_done(QDBusPendingCallWatcher* watcher)
     }
 
     // The backend is GO, so let's watch for it's possible disappearance, so we
-    // can invalidate the interface
+    // can invalidate the interface. We watch the session bus also when talking to the
+    // backend through a peer-to-peer connection since that one can not restart the service.
+    mBackendService = service_name();
     mServiceWatcher.addWatchedService(mBackendService);
 
     // Immediatelly request config
     connect(new GetConfigOperation, &GetConfigOperation::finished, this, [&](ConfigOperation* op) {
+        // A restarted service counts generations anew, the cache of the old one is replaced.
         mConfig = qobject_cast<GetConfigOperation*>(op)->config();
         emit_backend_ready();
     });
@@ -403,7 +543,7 @@ void BackendManager::on_backend_request_done(QDBusPendingCallWatcher* watcher)
             &org::kwinft::disman::backend::configChanged,
             this,
             [&](const QVariantMap& newConfig) {
-                mConfig = Disman::ConfigSerializer::deserialize_config(newConfig);
+                cache_config(Disman::ConfigSerializer::deserialize_config(newConfig));
             });
 }
 
@@ -422,6 +562,11 @@ void BackendManager::invalidate_interface()
     delete mInterface;
     mInterface = nullptr;
     mBackendService.clear();
+
+    if (!m_peer_connection.isEmpty()) {
+        QDBusConnection::disconnectFromPeer(m_peer_connection);
+        m_peer_connection.clear();
+    }
 }
 
 ConfigPtr BackendManager::config() const
@@ -434,40 +579,132 @@ void BackendManager::set_config(ConfigPtr c)
     mConfig = c;
 }
 
+void BackendManager::cache_config(ConfigPtr const& config)
+{
+    if (!config) {
+        return;
+    }
+
+    // Replies and change signals can arrive in any order. A config from an older generation than
+    // the cached one must not replace it. Generation zero is from services that do not count.
+    if (mConfig && config->generation() != 0 && config->generation() < mConfig->generation()) {
+        qCDebug(DISMAN) << "Ignoring config of generation" << config->generation()
+                        << "older than cached generation" << mConfig->generation();
+        return;
+    }
+    mConfig = config;
+}
+
+ConfigPtr BackendManager::cached_config() const
+{
+    if (mMethod != OutOfProcess || !mInterface || !mInterface->isValid()) {
+        return nullptr;
+    }
+    return mConfig;
+}
+
+void BackendManager::revalidate_config()
+{
+    Q_ASSERT(mMethod == OutOfProcess);
+
+    // One pending revalidation covers all cached answers handed out in the meantime.
+    if (m_revalidating) {
+        return;
+    }
+    m_revalidating = true;
+
+    auto revalidation = new GetConfigOperation;
+    connect(revalidation, &GetConfigOperation::finished, this, [this](ConfigOperation* op) {
+        m_revalidating = false;
+        if (op->has_error()) {
+            qCDebug(DISMAN) << "Revalidating cached config failed:" << op->error_string();
+            return;
+        }
+
+        auto const config = qobject_cast<GetConfigOperation*>(op)->config();
+        if (mConfig && config->compare(mConfig)) {
+            // Still take over the generation, so later set requests are based on it.
+            cache_config(config);
+            return;
+        }
+
+        auto const previous = mConfig;
+        cache_config(config);
+        if (mConfig == previous) {
+            return;
+        }
+
+        qCDebug(DISMAN) << "Cached config was stale.";
+        ConfigMonitor::instance()->update_configs(mConfig);
+    });
+}
+
 void BackendManager::shutdown_backend()
 {
     if (mMethod == InProcess) {
+        QElapsedTimer timer;
+        timer.start();
+
         delete mLoader;
         mLoader = nullptr;
         m_inProcessBackend.second.clear();
         delete m_inProcessBackend.first;
         m_inProcessBackend.first = nullptr;
-    } else {
 
-        if (mBackendService.isEmpty() && !mInterface) {
-            return;
-        }
+        qCDebug(DISMAN) << "In-process backend shut down after" << timer.elapsed() << "ms.";
+        return;
+    }
 
-        // If there are some currently pending requests, then wait for them to
-        // finish before quitting
-        while (mRequestsCounter > 0) {
-            mShutdownLoop.exec();
-        }
+    if (mBackendService.isEmpty() && !mInterface) {
+        return;
+    }
 
-        mServiceWatcher.removeWatchedService(mBackendService);
-        mShuttingDown = true;
+    // Requests that are currently pending get their backend first. Once the last one is done the
+    // shutdown is finished from emit_backend_ready.
+    if (mRequestsCounter > 0) {
+        qCDebug(DISMAN) << "Shutting down backend after" << mRequestsCounter << "pending requests.";
+        m_shutdown_pending = true;
+        return;
+    }
 
-        QDBusMessage call = QDBusMessage::createMethodCall(QStringLiteral("org.kwinft.disman"),
-                                                           QStringLiteral("/"),
-                                                           QStringLiteral("org.kwinft.disman"),
-                                                           QStringLiteral("quit"));
-        // Call synchronously
-        QDBusConnection::sessionBus().call(call);
-        invalidate_interface();
+    finish_shutdown();
+}
 
-        while (QDBusConnection::sessionBus().interface()->isServiceRegistered(
-            QStringLiteral("org.kwinft.disman"))) {
-            QThread::msleep(100);
-        }
+void BackendManager::finish_shutdown()
+{
+    m_shutdown_timer.start();
+
+    mServiceWatcher.removeWatchedService(mBackendService);
+    mShuttingDown = true;
+
+    // Watched before the call so the service can not leave unnoticed in between.
+    m_shutdown_watcher.addWatchedService(service_name());
+
+    QDBusMessage call = QDBusMessage::createMethodCall(service_name(),
+                                                       QStringLiteral("/"),
+                                                       QStringLiteral("org.kwinft.disman"),
+                                                       QStringLiteral("quit"));
+    // Call synchronously, so the service got it even when we exit right after.
+    QDBusConnection::sessionBus().call(call);
+    invalidate_interface();
+
+    if (!QDBusConnection::sessionBus().interface()->isServiceRegistered(service_name())) {
+        complete_shutdown();
+    }
+}
+
+void BackendManager::complete_shutdown()
+{
+    if (!mShuttingDown) {
+        return;
+    }
+
+    m_shutdown_watcher.removeWatchedService(service_name());
+    mShuttingDown = false;
+    qCDebug(DISMAN) << "Backend service shut down after" << m_shutdown_timer.elapsed() << "ms.";
+
+    if (mMethod == OutOfProcess && mRequestsCounter > 0) {
+        // Requested while the old service was still on the bus.
+        start_backend(QString::fromLatin1(qgetenv("DISMAN_BACKEND")), backend_arguments());
     }
 }
@@ -26,11 +26,13 @@
 #ifndef DISMAN_BACKENDMANAGER_H
 #define DISMAN_BACKENDMANAGER_H
 
+#include <QDBusConnection>
 #include <QDBusServiceWatcher>
-#include <QEventLoop>
+#include <QElapsedTimer>
 #include <QFileInfoList>
 #include <QObject>
 #include <QPluginLoader>
+#include <QPointer>
 #include <QProcess>
 #include <QTimer>
 
@@ -46,6 +48,7 @@ namespace Disman
 {
 
 class Backend;
+class SetConfigOperation;
 
 class DISMAN_EXPORT BackendManager : public QObject
 {
@@ -60,6 +63,21 @@ public:
     Disman::ConfigPtr config() const;
     void set_config(Disman::ConfigPtr c);
 
+    /**
+     * The last config received from the backend service while connected to it. Can be used to
+     * answer config requests without a round trip to the service. Call revalidate_config()
+     * afterwards to learn about a stale cache.
+     *
+     * @return cached config or null when not connected
+     */
+    Disman::ConfigPtr cached_config() const;
+
+    /**
+     * Requests the current config from the backend service. If it differs from the cached one,
+     * the cache is updated and watched configs are notified through the ConfigMonitor.
+     */
+    void revalidate_config();
+
     /** Choose which backend to use
      *
      * This method uses a couple of heuristics to pick the backend to be loaded:
@@ -97,6 +115,18 @@ public:
 
     Disman::Backend* load_backend_in_process(const QString& name);
 
+    /**
+     * The instance name set through the environment variable DISMAN_INSTANCE. Several backend
+     * services can run side by side on one session bus when each has its own instance name, for
+     * example one per nested X server. Each instance also has its own control files.
+     *
+     * @return the instance name or an empty string for the default instance
+     */
+    static QString instance_name();
+
+    /// Bus name of the backend service for the instance of this process.
+    static QString service_name();
+
     BackendManager::Method method() const;
     void set_method(BackendManager::Method m);
 
@@ -119,9 +149,15 @@ private:
     void init_method();
     Q_INVOKABLE void emit_backend_ready();
 
+    void finish_shutdown();
+    void complete_shutdown();
+
     void start_backend(const QString& backend = QString(),
                        const QVariantMap& arguments = QVariantMap());
     void on_backend_request_done(QDBusPendingCallWatcher* watcher);
+    void on_peer_address_received(QDBusPendingCallWatcher* watcher);
+    void connect_interface(QDBusConnection const& connection);
+    void cache_config(Disman::ConfigPtr const& config);
     void backend_service_unregistered(const QString& service_name);
 
     // For out-of-process operation
@@ -132,12 +168,23 @@ private:
     int mCrashCount;
 
     QString mBackendService;
+    QString m_peer_connection;
+    bool m_use_peer_connection{true};
+    bool m_revalidating{false};
+
+    // Set operations are coalesced. Only one is sent at a time, and only the latest one waits.
+    QPointer<SetConfigOperation> m_set_op_in_flight;
+    QPointer<SetConfigOperation> m_set_op_queued;
     QDBusServiceWatcher mServiceWatcher;
+
+    // Watches the service while it quits. Requests meanwhile wait for it to leave the bus.
+    QDBusServiceWatcher m_shutdown_watcher;
+    QElapsedTimer m_shutdown_timer;
     Disman::ConfigPtr mConfig;
     QTimer mResetCrashCountTimer;
     bool mShuttingDown;
     int mRequestsCounter;
-    QEventLoop mShutdownLoop;
+    bool m_shutdown_pending{false};
 
     // For in-process operation
     QPluginLoader* mLoader;
@@ -78,6 +78,7 @@ public:
     bool tablet_mode_available;
     bool tablet_mode_engaged;
     Cause cause;
+    uint64_t generation{0};
 
 private:
     Config* q;
@@ -204,7 +205,9 @@ Config::~Config()
 ConfigPtr Config::clone() const
 {
     ConfigPtr newConfig(new Config(cause()));
-    newConfig->d->screen = d->screen->clone();
+    if (d->screen) {
+        newConfig->d->screen = d->screen->clone();
+    }
 
     for (auto const& [key, ourOutput] : d->outputs) {
         auto cloned_output = ourOutput->clone();
@@ -218,6 +221,7 @@ ConfigPtr Config::clone() const
     newConfig->set_supported_features(supported_features());
     newConfig->set_tablet_mode_available(tablet_mode_available());
     newConfig->set_tablet_mode_engaged(tablet_mode_engaged());
+    newConfig->set_generation(generation());
 
     return newConfig;
 }
@@ -294,6 +298,16 @@ void Config::set_cause(Cause cause)
     d->cause = cause;
 }
 
+uint64_t Config::generation() const
+{
+    return d->generation;
+}
+
+void Config::set_generation(uint64_t generation)
+{
+    d->generation = generation;
+}
+
 ScreenPtr Config::screen() const
 {
     return d->screen;
@@ -449,6 +463,7 @@ void Config::apply(const ConfigPtr& other)
     // Update validity
     set_valid(other->valid());
     set_cause(other->cause());
+    set_generation(other->generation());
 }
 
 std::string Config::log() const
@@ -147,6 +147,22 @@ public:
     Cause cause() const;
     void set_cause(Cause cause);
 
+    /**
+     * The generation of the backend config this config was taken from. The backend service
+     * increases the generation with every change to its config. It is zero when unknown.
+     *
+     * When setting a config its generation tells the service on which state the config is
+     * based. The changes made to an outdated state are moved onto the current one. If that is
+     * not possible, for example because outputs were added or removed since, the config is
+     * rejected and must be set again based on the current state.
+     *
+     * The generation is copied on clone and apply, but not considered on compare.
+     *
+     * @return generation of the config
+     */
+    uint64_t generation() const;
+    void set_generation(uint64_t generation);
+
     ScreenPtr screen() const;
     void setScreen(const ScreenPtr& screen);
 
@@ -22,7 +22,9 @@
 #include "configserializer_p.h"
 #include "disman_debug.h"
 #include "getconfigoperation.h"
+#include "log.h"
 #include "output.h"
+#include "trace.h"
 
 #include <QDBusPendingCallWatcher>
 
@@ -124,6 +126,7 @@ void ConfigMonitor::Private::backend_config_changed(const QVariantMap& configMap
 
 void ConfigMonitor::Private::update_configs(const Disman::ConfigPtr& newConfig)
 {
+    DISMAN_TRACE_SPAN("ConfigMonitor::update_configs");
     QMutableListIterator<std::weak_ptr<Config>> iter(watched_configs);
     while (iter.hasNext()) {
         Disman::ConfigPtr config = iter.next().lock();
@@ -218,10 +221,15 @@ void ConfigMonitor::connect_in_process_backend(Disman::Backend* backend)
         if (!config) {
             return;
         }
-        qCDebug(DISMAN) << "Backend change!" << config;
+        DISMAN_LOG_CONFIG(DISMAN, QStringLiteral("Backend change!"), config);
         BackendManager::instance()->set_config(config);
         d->update_configs(config);
     });
 }
 
+void ConfigMonitor::update_configs(Disman::ConfigPtr const& config)
+{
+    d->update_configs(config);
+}
+
 #include "configmonitor.moc"
@@ -51,6 +51,7 @@ private:
 
     friend BackendManager;
     void connect_in_process_backend(Disman::Backend* backend);
+    void update_configs(Disman::ConfigPtr const& config);
 
     class Private;
     Private* const d;
@@ -23,6 +23,8 @@
 
 #include "disman_debug.h"
 
+#include <QEventLoop>
+
 using namespace Disman;
 
 ConfigOperationPrivate::ConfigOperationPrivate(ConfigOperation* qq)
@@ -146,3 +148,32 @@ Disman::Backend* ConfigOperationPrivate::loadBackend()
     }
     return backend;
 }
+
+void ConfigOperationPrivate::with_backend(std::function<void(Disman::Backend*)> const& function)
+{
+    auto backend = loadBackend();
+    if (!backend) {
+        return;
+    }
+    if (!backend->initializing()) {
+        function(backend);
+        return;
+    }
+
+    connect(
+        backend,
+        &Backend::init_finished,
+        this,
+        [this, backend, function] {
+            Q_Q(ConfigOperation);
+            if (!backend->valid()) {
+                auto const e = QStringLiteral("Backend failed to initialize");
+                qCDebug(DISMAN) << e;
+                q->set_error(e);
+                q->emit_result();
+                return;
+            }
+            function(backend);
+        },
+        Qt::SingleShotConnection);
+}
@@ -22,6 +22,8 @@
 #include "backendinterface.h"
 #include "configoperation.h"
 
+#include <functional>
+
 namespace Disman
 {
 class ConfigOperationPrivate : public QObject
@@ -39,6 +41,12 @@ public:
     // For in-process
     Disman::Backend* loadBackend();
 
+    /**
+     * Calls @p function with the loaded backend once it is initialized. If loading or
+     * initializing the backend fails the error is set and the result emitted instead.
+     */
+    void with_backend(std::function<void(Disman::Backend*)> const& function);
+
 public Q_SLOTS:
     void do_emit_result();
 
@@ -19,9 +19,11 @@
 #include "configserializer_p.h"
 
 #include "config.h"
+#include "configsnapshot.h"
 #include "disman_debug.h"
 #include "mode.h"
 #include "screen.h"
+#include "trace.h"
 
 #include <QDBusArgument>
 #include <QFile>
@@ -59,6 +61,7 @@ QJsonObject ConfigSerializer::serialize_sizef(const QSizeF& size)
 
 QJsonObject ConfigSerializer::serialize_config(const ConfigPtr& config)
 {
+    DISMAN_TRACE_SPAN("ConfigSerializer::serialize_config");
     QJsonObject obj;
 
     if (!config) {
@@ -66,6 +69,10 @@ QJsonObject ConfigSerializer::serialize_config(const ConfigPtr& config)
     }
 
     obj[QLatin1String("cause")] = static_cast<int>(config->cause());
+    obj[QLatin1String("generation")] = static_cast<qint64>(config->generation());
+    if (auto const trace_id = Trace::current_id()) {
+        obj[QLatin1String("trace-id")] = static_cast<qint64>(trace_id);
+    }
     obj[QLatin1String("features")] = static_cast<int>(config->supported_features());
     if (auto primary = config->primary_output()) {
         obj[QLatin1String("primary-output")] = primary->id();
@@ -86,6 +93,11 @@ QJsonObject ConfigSerializer::serialize_config(const ConfigPtr& config)
     return obj;
 }
 
+QJsonObject ConfigSerializer::serialize_config(ConfigSnapshot const& snapshot)
+{
+    return serialize_config(snapshot.to_config());
+}
+
 QJsonObject ConfigSerializer::serialize_output(const OutputPtr& output)
 {
     QJsonObject obj;
@@ -266,6 +278,11 @@ QSizeF ConfigSerializer::deserialize_sizef(const QDBusArgument& arg)
 
 ConfigPtr ConfigSerializer::deserialize_config(const QVariantMap& map)
 {
+    if (Trace::enabled() && map.contains(QLatin1String("trace-id"))) {
+        Trace::set_current_id(map[QStringLiteral("trace-id")].toULongLong());
+    }
+    DISMAN_TRACE_SPAN("ConfigSerializer::deserialize_config");
+
     auto cause = static_cast<Config::Cause>(
         map.value(QStringLiteral("cause"), static_cast<int>(Config::Cause::unknown)).toInt());
     switch (cause) {
@@ -281,6 +298,10 @@ ConfigPtr ConfigSerializer::deserialize_config(const QVariantMap& map)
 
     ConfigPtr config(new Config(cause));
 
+    if (map.contains(QLatin1String("generation"))) {
+        config->set_generation(map[QStringLiteral("generation")].toULongLong());
+    }
+
     if (map.contains(QLatin1String("features"))) {
         config->set_supported_features(
             static_cast<Config::Features>(map[QStringLiteral("features")].toInt()));
@@ -502,3 +523,142 @@ ScreenPtr ConfigSerializer::deserialize_screen(const QDBusArgument& arg)
     arg.endMap();
     return screen;
 }
+
+static QSize json_size(QJsonValue const& value)
+{
+    auto const obj = value.toObject();
+    return QSize(obj[QLatin1String("width")].toInt(), obj[QLatin1String("height")].toInt());
+}
+
+static QPointF json_point(QJsonValue const& value)
+{
+    auto const obj = value.toObject();
+    return QPointF(obj[QLatin1String("x")].toDouble(), obj[QLatin1String("y")].toDouble());
+}
+
+static ModePtr json_mode(QJsonObject const& obj)
+{
+    ModePtr mode(new Mode);
+    mode->set_id(obj[QLatin1String("id")].toString().toStdString());
+    mode->set_name(obj[QLatin1String("name")].toString().toStdString());
+    mode->set_size(json_size(obj[QLatin1String("size")]));
+    mode->set_refresh(obj[QLatin1String("refresh")].toInt());
+    return mode;
+}
+
+static OutputPtr json_output(QJsonObject const& obj)
+{
+    OutputPtr output(new Output);
+
+    ModeMap modes;
+    for (auto const& value : obj[QLatin1String("modes")].toArray()) {
+        auto const mode = json_mode(value.toObject());
+        modes.insert({mode->id(), mode});
+    }
+    output->set_modes(modes);
+
+    output->set_id(obj[QLatin1String("id")].toInt());
+    output->set_name(obj[QLatin1String("name")].toString().toStdString());
+    output->set_description(obj[QLatin1String("description")].toString().toStdString());
+    output->set_hash_raw(obj[QLatin1String("hash")].toString().toStdString());
+    output->setType(static_cast<Output::Type>(obj[QLatin1String("type")].toInt()));
+    output->set_position(json_point(obj[QLatin1String("position")]));
+    output->set_scale(obj[QLatin1String("scale")].toDouble());
+    output->set_rotation(static_cast<Output::Rotation>(obj[QLatin1String("rotation")].toInt()));
+    output->set_resolution(json_size(obj[QLatin1String("resolution")]));
+    output->set_refresh_rate(obj[QLatin1String("refresh")].toInt());
+
+    std::vector<std::string> preferred_modes;
+    for (auto const& value : obj[QLatin1String("preferred_modes")].toArray()) {
+        preferred_modes.push_back(value.toString().toStdString());
+    }
+    output->set_preferred_modes(preferred_modes);
+
+    output->set_follow_preferred_mode(obj[QLatin1String("follow_preferred_mode")].toBool());
+    output->set_enabled(obj[QLatin1String("enabled")].toBool());
+    output->set_physical_size(json_size(obj[QLatin1String("physical_size")]));
+    output->set_replication_source(obj[QLatin1String("replication_source")].toInt());
+    output->set_auto_rotate(obj[QLatin1String("auto_rotate")].toBool());
+    output->set_auto_rotate_only_in_tablet_mode(
+        obj[QLatin1String("auto_rotate_only_in_tablet_mode")].toBool());
+    output->set_auto_resolution(obj[QLatin1String("auto_resolution")].toBool());
+    output->set_auto_refresh_rate(obj[QLatin1String("auto_refresh_rate")].toBool());
+    output->set_retention(
+        ConfigSerializer::deserialize_retention(obj[QLatin1String("retention")].toVariant()));
+    output->set_adaptive_sync_toggle_support(
+        obj[QLatin1String("adaptive_sync_toggle_support")].toBool());
+    output->set_adaptive_sync(obj[QLatin1String("adaptive_sync")].toBool());
+
+    if (obj[QLatin1String("global")].toBool()) {
+        Output::GlobalData data;
+        data.valid = true;
+        data.resolution = json_size(obj[QLatin1String("global.resolution")]);
+        data.refresh = obj[QLatin1String("global.refresh")].toInt();
+        data.rotation
+            = static_cast<Output::Rotation>(obj[QLatin1String("global.rotation")].toInt());
+        data.scale = obj[QLatin1String("global.scale")].toDouble();
+        data.auto_resolution = obj[QLatin1String("global.auto_resolution")].toBool();
+        data.auto_refresh_rate = obj[QLatin1String("global.auto_refresh_rate")].toBool();
+        data.auto_rotate = obj[QLatin1String("global.auto_rotate")].toBool();
+        data.auto_rotate_only_in_tablet_mode
+            = obj[QLatin1String("global.auto_rotate_only_in_tablet_mode")].toBool();
+        output->set_global_data(data);
+    }
+
+    return output;
+}
+
+static ScreenPtr json_screen(QJsonObject const& obj)
+{
+    ScreenPtr screen(new Screen);
+    screen->set_id(obj[QLatin1String("id")].toInt());
+    screen->set_max_outputs_count(obj[QLatin1String("max_outputs_count")].toInt());
+    screen->set_current_size(json_size(obj[QLatin1String("current_size")]));
+    screen->set_max_size(json_size(obj[QLatin1String("max_size")]));
+    screen->set_min_size(json_size(obj[QLatin1String("min_size")]));
+    return screen;
+}
+
+ConfigPtr ConfigSerializer::deserialize_config(QJsonObject const& obj)
+{
+    auto cause = static_cast<Config::Cause>(
+        obj[QLatin1String("cause")].toInt(static_cast<int>(Config::Cause::unknown)));
+    switch (cause) {
+    case Config::Cause::unknown:
+    case Config::Cause::generated:
+    case Config::Cause::file:
+    case Config::Cause::interactive:
+        break;
+    default:
+        qCWarning(DISMAN) << "Deserialized config without valid cause value.";
+        cause = Config::Cause::unknown;
+    }
+
+    ConfigPtr config(new Config(cause));
+    config->set_generation(obj[QLatin1String("generation")].toInteger());
+    config->set_supported_features(
+        static_cast<Config::Features>(obj[QLatin1String("features")].toInt()));
+    config->set_tablet_mode_available(obj[QLatin1String("tablet_mode_available")].toBool());
+    config->set_tablet_mode_engaged(obj[QLatin1String("tablet_mode_engaged")].toBool());
+
+    OutputMap outputs;
+    for (auto const& value : obj[QLatin1String("outputs")].toArray()) {
+        auto const output = json_output(value.toObject());
+        outputs.insert({output->id(), output});
+    }
+    config->set_outputs(outputs);
+
+    if (obj.contains(QLatin1String("primary-output"))) {
+        auto output = config->output(obj[QLatin1String("primary-output")].toInt());
+        if (!output) {
+            return ConfigPtr();
+        }
+        config->set_primary_output(output);
+    }
+
+    if (obj.contains(QLatin1String("screen"))) {
+        config->setScreen(json_screen(obj[QLatin1String("screen")].toObject()));
+    }
+
+    return config;
+}
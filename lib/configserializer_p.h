@@ -31,6 +31,7 @@
 
 namespace Disman
 {
+class ConfigSnapshot;
 
 namespace ConfigSerializer
 {
@@ -49,6 +50,8 @@ DISMAN_EXPORT QJsonArray serialize_list(const QList<T>& list)
 }
 
 DISMAN_EXPORT QJsonObject serialize_config(const Disman::ConfigPtr& config);
+/// Safe to call on any thread as it works on a config of its own.
+DISMAN_EXPORT QJsonObject serialize_config(Disman::ConfigSnapshot const& snapshot);
 DISMAN_EXPORT QJsonObject serialize_output(const Disman::OutputPtr& output);
 DISMAN_EXPORT QJsonObject serialize_mode(const Disman::ModePtr& mode);
 DISMAN_EXPORT QJsonObject serialize_screen(const Disman::ScreenPtr& screen);
@@ -70,6 +73,8 @@ DISMAN_EXPORT QList<T> deserialize_list(const QDBusArgument& arg)
     return list;
 }
 DISMAN_EXPORT Disman::ConfigPtr deserialize_config(const QVariantMap& map);
+/// From the JSON created by serialize_config, for data not received over D-Bus.
+DISMAN_EXPORT Disman::ConfigPtr deserialize_config(QJsonObject const& obj);
 DISMAN_EXPORT Disman::OutputPtr deserialize_output(const QDBusArgument& output);
 DISMAN_EXPORT Disman::ModePtr deserialize_mode(const QDBusArgument& mode);
 DISMAN_EXPORT Disman::ScreenPtr deserialize_screen(const QDBusArgument& screen);
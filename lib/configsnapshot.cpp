@@ -0,0 +1,273 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "configsnapshot.h"
+
+#include "mode.h"
+#include "output_p.h"
+#include "screen.h"
+
+#include <algorithm>
+
+namespace Disman
+{
+
+struct ConfigSnapshot::Data {
+    Config::Cause cause{Config::Cause::unknown};
+    uint64_t generation{0};
+    bool valid{true};
+
+    Config::Features supported_features{Config::Feature::None};
+    bool tablet_mode_available{false};
+    bool tablet_mode_engaged{false};
+
+    bool has_screen{false};
+    ScreenSnapshot screen;
+
+    std::vector<OutputSnapshot> outputs;
+    int primary_output_id{0};
+    QString hash;
+};
+
+static OutputSnapshot output_snapshot(Output::Private const& output)
+{
+    OutputSnapshot snapshot;
+
+    snapshot.id = output.id;
+    snapshot.name = output.name;
+    snapshot.description = output.description;
+    snapshot.hash = output.hash;
+    snapshot.type = output.type;
+
+    for (auto const& [key, mode] : output.modeList) {
+        snapshot.modes.push_back({mode->id(), mode->name(), mode->size(), mode->refresh()});
+    }
+    snapshot.preferred_mode = output.preferredMode;
+    snapshot.preferred_modes = output.preferred_modes;
+
+    snapshot.resolution = output.resolution;
+    snapshot.refresh_rate = output.refresh_rate;
+    snapshot.adaptive_sync = output.adapt_sync;
+    snapshot.adaptive_sync_toggle_support = output.supports_adapt_sync_toggle;
+
+    snapshot.replication_source = output.replication_source;
+    snapshot.physical_size = output.physical_size;
+    snapshot.position = output.position;
+    snapshot.enforced_geometry = output.enforced_geometry;
+    snapshot.rotation = output.rotation;
+    snapshot.scale = output.scale;
+    snapshot.enabled = output.enabled;
+    snapshot.follow_preferred_mode = output.follow_preferred_mode;
+
+    snapshot.auto_resolution = output.auto_resolution;
+    snapshot.auto_refresh_rate = output.auto_refresh_rate;
+    snapshot.auto_rotate = output.auto_rotate;
+    snapshot.auto_rotate_only_in_tablet_mode = output.auto_rotate_only_in_tablet_mode;
+
+    snapshot.retention = output.retention;
+    snapshot.global = output.global;
+
+    return snapshot;
+}
+
+static void restore_output(OutputSnapshot const& snapshot, Output::Private& output)
+{
+    output.id = snapshot.id;
+    output.name = snapshot.name;
+    output.description = snapshot.description;
+    output.hash = snapshot.hash;
+    output.type = snapshot.type;
+
+    for (auto const& mode_snapshot : snapshot.modes) {
+        auto mode = std::make_shared<Mode>();
+        mode->set_id(mode_snapshot.id);
+        mode->set_name(mode_snapshot.name);
+        mode->set_size(mode_snapshot.size);
+        mode->set_refresh(mode_snapshot.refresh);
+        output.modeList.insert({mode_snapshot.id, mode});
+    }
+    output.preferredMode = snapshot.preferred_mode;
+    output.preferred_modes = snapshot.preferred_modes;
+
+    output.resolution = snapshot.resolution;
+    output.refresh_rate = snapshot.refresh_rate;
+    output.adapt_sync = snapshot.adaptive_sync;
+    output.supports_adapt_sync_toggle = snapshot.adaptive_sync_toggle_support;
+
+    output.replication_source = snapshot.replication_source;
+    output.physical_size = snapshot.physical_size;
+    output.position = snapshot.position;
+    output.enforced_geometry = snapshot.enforced_geometry;
+    output.rotation = snapshot.rotation;
+    output.scale = snapshot.scale;
+    output.enabled = snapshot.enabled;
+    output.follow_preferred_mode = snapshot.follow_preferred_mode;
+
+    output.auto_resolution = snapshot.auto_resolution;
+    output.auto_refresh_rate = snapshot.auto_refresh_rate;
+    output.auto_rotate = snapshot.auto_rotate;
+    output.auto_rotate_only_in_tablet_mode = snapshot.auto_rotate_only_in_tablet_mode;
+
+    output.retention = snapshot.retention;
+    output.global = snapshot.global;
+}
+
+ConfigSnapshot::ConfigSnapshot() = default;
+
+ConfigSnapshot::ConfigSnapshot(ConfigPtr const& config)
+{
+    if (!config) {
+        return;
+    }
+
+    auto data = std::make_shared<Data>();
+
+    data->cause = config->cause();
+    data->generation = config->generation();
+    data->valid = config->valid();
+    data->supported_features = config->supported_features();
+    data->tablet_mode_available = config->tablet_mode_available();
+    data->tablet_mode_engaged = config->tablet_mode_engaged();
+
+    if (auto screen = config->screen()) {
+        data->has_screen = true;
+        data->screen = {screen->id(),
+                        screen->current_size(),
+                        screen->min_size(),
+                        screen->max_size(),
+                        screen->max_outputs_count()};
+    }
+
+    // The output map is sorted by id already.
+    for (auto const& [id, output] : config->outputs()) {
+        data->outputs.push_back(output_snapshot(*output->d));
+    }
+    if (auto primary = config->primary_output()) {
+        data->primary_output_id = primary->id();
+    }
+    data->hash = config->hash();
+
+    d = data;
+}
+
+bool ConfigSnapshot::is_null() const
+{
+    return !d;
+}
+
+ConfigPtr ConfigSnapshot::to_config() const
+{
+    if (!d) {
+        return ConfigPtr();
+    }
+
+    auto config = std::make_shared<Config>(d->cause);
+    config->set_generation(d->generation);
+    config->set_valid(d->valid);
+    config->set_supported_features(d->supported_features);
+    config->set_tablet_mode_available(d->tablet_mode_available);
+    config->set_tablet_mode_engaged(d->tablet_mode_engaged);
+
+    if (d->has_screen) {
+        auto screen = std::make_shared<Screen>();
+        screen->set_id(d->screen.id);
+        screen->set_current_size(d->screen.current_size);
+        screen->set_min_size(d->screen.min_size);
+        screen->set_max_size(d->screen.max_size);
+        screen->set_max_outputs_count(d->screen.max_outputs_count);
+        config->setScreen(screen);
+    }
+
+    for (auto const& snapshot : d->outputs) {
+        auto output = std::make_shared<Output>();
+        restore_output(snapshot, *output->d);
+        config->add_output(output);
+
+        if (snapshot.id == d->primary_output_id) {
+            config->set_primary_output(output);
+        }
+    }
+
+    return config;
+}
+
+Config::Cause ConfigSnapshot::cause() const
+{
+    return d ? d->cause : Config::Cause::unknown;
+}
+
+uint64_t ConfigSnapshot::generation() const
+{
+    return d ? d->generation : 0;
+}
+
+bool ConfigSnapshot::valid() const
+{
+    return d && d->valid;
+}
+
+Config::Features ConfigSnapshot::supported_features() const
+{
+    return d ? d->supported_features : Config::Feature::None;
+}
+
+bool ConfigSnapshot::tablet_mode_available() const
+{
+    return d && d->tablet_mode_available;
+}
+
+bool ConfigSnapshot::tablet_mode_engaged() const
+{
+    return d && d->tablet_mode_engaged;
+}
+
+ScreenSnapshot const* ConfigSnapshot::screen() const
+{
+    return d && d->has_screen ? &d->screen : nullptr;
+}
+
+std::vector<OutputSnapshot> const& ConfigSnapshot::outputs() const
+{
+    static std::vector<OutputSnapshot> const none;
+    return d ? d->outputs : none;
+}
+
+OutputSnapshot const* ConfigSnapshot::output(int id) const
+{
+    auto const& outputs = this->outputs();
+    auto const it = std::lower_bound(
+        outputs.begin(), outputs.end(), id, [](auto const& output, int id) {
+            return output.id < id;
+        });
+    return it != outputs.end() && it->id == id ? &*it : nullptr;
+}
+
+int ConfigSnapshot::primary_output_id() const
+{
+    return d ? d->primary_output_id : 0;
+}
+
+QString ConfigSnapshot::hash() const
+{
+    return d ? d->hash : QString();
+}
+
+bool ConfigSnapshot::compare(ConfigSnapshot const& other) const
+{
+    if (!d || !other.d) {
+        return !d && !other.d;
+    }
+    if (d == other.d) {
+        return true;
+    }
+    if (d->hash != other.d->hash || d->outputs.size() != other.d->outputs.size()) {
+        return false;
+    }
+
+    // The output comparison has many rules that are not worth duplicating here.
+    return to_config()->compare(other.to_config());
+}
+
+}
@@ -0,0 +1,128 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include "config.h"
+#include "disman_export.h"
+#include "output.h"
+#include "types.h"
+
+#include <QMetaType>
+#include <QPointF>
+#include <QRectF>
+#include <QSize>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Disman
+{
+
+struct ModeSnapshot {
+    std::string id;
+    std::string name;
+    QSize size;
+    int refresh{0};
+};
+
+struct OutputSnapshot {
+    int id{0};
+    std::string name;
+    std::string description;
+    std::string hash;
+    Output::Type type{Output::Unknown};
+
+    std::vector<ModeSnapshot> modes;
+    std::string preferred_mode;
+    std::vector<std::string> preferred_modes;
+
+    QSize resolution;
+    int refresh_rate{0};
+    bool adaptive_sync{false};
+    bool adaptive_sync_toggle_support{false};
+
+    int replication_source{0};
+    QSize physical_size;
+    QPointF position;
+
+    /// Invalid unless the geometry was forced, for example to the one of a replication source.
+    QRectF enforced_geometry;
+    Output::Rotation rotation{Output::None};
+    double scale{1.};
+    bool enabled{false};
+    bool follow_preferred_mode{false};
+
+    bool auto_resolution{false};
+    bool auto_refresh_rate{false};
+    bool auto_rotate{true};
+    bool auto_rotate_only_in_tablet_mode{true};
+
+    Output::Retention retention{Output::Retention::Undefined};
+    Output::GlobalData global;
+};
+
+struct ScreenSnapshot {
+    int id{0};
+    QSize current_size;
+    QSize min_size;
+    QSize max_size;
+    int max_outputs_count{0};
+};
+
+/**
+ * An immutable copy of a config in plain values.
+ *
+ * Other than Config it holds no QObjects. Copies share the same data, so a snapshot taken on one
+ * thread can be passed to and read on any other thread.
+ *
+ * Code that needs a Config, like the Generator or the ConfigSerializer, can work on a snapshot
+ * through to_config on any thread, as the created config is only owned by the caller.
+ */
+class DISMAN_EXPORT ConfigSnapshot
+{
+public:
+    /// A null snapshot.
+    ConfigSnapshot();
+    explicit ConfigSnapshot(ConfigPtr const& config);
+
+    bool is_null() const;
+
+    /// A new config with the values of the snapshot. Null for a null snapshot.
+    ConfigPtr to_config() const;
+
+    Config::Cause cause() const;
+    uint64_t generation() const;
+    bool valid() const;
+
+    Config::Features supported_features() const;
+    bool tablet_mode_available() const;
+    bool tablet_mode_engaged() const;
+
+    /// Null if the config has no screen.
+    ScreenSnapshot const* screen() const;
+
+    /// Sorted by id.
+    std::vector<OutputSnapshot> const& outputs() const;
+    OutputSnapshot const* output(int id) const;
+
+    /// The id of the primary output or 0 if there is none.
+    int primary_output_id() const;
+
+    /// Same as Config::hash of the config the snapshot was taken of.
+    QString hash() const;
+
+    /// Same as Config::compare on the configs of both snapshots.
+    bool compare(ConfigSnapshot const& other) const;
+
+private:
+    struct Data;
+    std::shared_ptr<Data const> d;
+};
+
+}
+
+Q_DECLARE_METATYPE(Disman::ConfigSnapshot)
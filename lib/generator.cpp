@@ -20,6 +20,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "output_p.h"
 
 #include "disman_debug.h"
+#include "log.h"
+#include "trace.h"
 
 #include <QRectF>
 
@@ -64,6 +66,7 @@ ConfigPtr Generator::config() const
 
 bool Generator::optimize()
 {
+    DISMAN_TRACE_SPAN("Generator::optimize");
     assert(m_config);
 
     auto config = optimize_impl();
@@ -74,7 +77,7 @@ bool Generator::optimize()
     }
     config->set_cause(Config::Cause::generated);
 
-    qCDebug(DISMAN) << "Config optimized:" << config;
+    DISMAN_LOG_CONFIG(DISMAN, QStringLiteral("Config optimized:"), config);
     m_config->apply(config);
     assert(check_config(m_config));
     return true;
@@ -131,7 +134,7 @@ bool Generator::extend(OutputPtr const& first, Extend_direction direction)
     }
     config->set_cause(Config::Cause::unknown);
 
-    qCDebug(DISMAN) << "Generated extension configuration:" << config;
+    DISMAN_LOG_CONFIG(DISMAN, QStringLiteral("Generated extension configuration:"), config);
     m_config->apply(config);
     return true;
 }
@@ -149,7 +152,7 @@ bool Generator::replicate()
     }
     config->set_cause(Config::Cause::unknown);
 
-    qCDebug(DISMAN) << "Generated replica configuration:" << config;
+    DISMAN_LOG_CONFIG(DISMAN, QStringLiteral("Generated replica configuration:"), config);
     m_config->apply(config);
     return true;
 }
@@ -42,6 +42,8 @@ public:
 
 public:
     ConfigPtr config;
+    GetConfigOperation::Options options;
+    bool cached{false};
 
     // For out-of-process
     QPointer<org::kwinft::disman::backend> mBackend;
@@ -100,8 +102,15 @@ void GetConfigOperationPrivate::onConfigReceived(QDBusPendingCallWatcher* watche
 }
 
 GetConfigOperation::GetConfigOperation(QObject* parent)
+    : GetConfigOperation(Option::None, parent)
+{
+}
+
+GetConfigOperation::GetConfigOperation(Options options, QObject* parent)
     : ConfigOperation(new GetConfigOperationPrivate(this), parent)
 {
+    Q_D(GetConfigOperation);
+    d->options = options;
 }
 
 GetConfigOperation::~GetConfigOperation()
@@ -114,19 +123,37 @@ Disman::ConfigPtr GetConfigOperation::config() const
     return d->config;
 }
 
+bool GetConfigOperation::cached() const
+{
+    Q_D(const GetConfigOperation);
+    return d->cached;
+}
+
 void GetConfigOperation::start()
 {
     Q_D(GetConfigOperation);
     if (BackendManager::instance()->method() == BackendManager::InProcess) {
-        auto backend = d->loadBackend();
-        if (!backend) {
-            return; // loadBackend() already set error and called emit_result() for us
+        // On failure with_backend() sets the error and calls emit_result() for us.
+        d->with_backend([this](Backend* backend) {
+            Q_D(GetConfigOperation);
+            d->config = backend->config()->clone();
+            emit_result();
+        });
+        return;
+    }
+
+    if (d->options & Option::Cached) {
+        auto manager = BackendManager::instance();
+        if (auto cached_config = manager->cached_config()) {
+            d->config = cached_config->clone();
+            d->cached = true;
+            emit_result();
+            manager->revalidate_config();
+            return;
         }
-        d->config = backend->config()->clone();
-        emit_result();
-    } else {
-        d->request_backend();
     }
+
+    d->request_backend();
 }
 
 #include "getconfigoperation.moc"
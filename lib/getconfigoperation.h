@@ -33,11 +33,29 @@ class DISMAN_EXPORT GetConfigOperation : public Disman::ConfigOperation
     Q_OBJECT
 
 public:
+    enum class Option {
+        None = 0x0,
+        /**
+         * Finish immediately with the last config received from the backend service, when
+         * available. The cached config is revalidated in the background afterwards. If it turns
+         * out to be stale, watched configs are updated and ConfigMonitor::configuration_changed
+         * is emitted. Has no effect with an in-process backend.
+         */
+        Cached = 0x1,
+    };
+    Q_DECLARE_FLAGS(Options, Option)
+
     explicit GetConfigOperation(QObject* parent = nullptr);
+    explicit GetConfigOperation(Options options, QObject* parent = nullptr);
     ~GetConfigOperation() override;
 
     Disman::ConfigPtr config() const override;
 
+    /**
+     * @return true if the config was served from the cache without asking the backend
+     */
+    bool cached() const;
+
 protected:
     void start() override;
 
@@ -46,4 +64,6 @@ private:
 };
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(Disman::GetConfigOperation::Options)
+
 #endif
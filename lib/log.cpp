@@ -17,24 +17,44 @@
  *************************************************************************************/
 #include "log.h"
 
+#include "config.h"
+#include "configserializer_p.h"
+#include "configsnapshot.h"
+
+#include <QCborMap>
+#include <QCborValue>
+#include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QStandardPaths>
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace Disman
 {
 
 Log* Log::sInstance = nullptr;
 QtMessageHandler sDefaultMessageHandler = nullptr;
 
+// The instance with a running writer thread.
+static Log* sWritingLog = nullptr;
+
 void dismanLogOutput(QtMsgType type, const QMessageLogContext& context, const QString& msg)
 {
     auto category = QString::fromLocal8Bit(context.category);
     if (category.startsWith(QLatin1String("disman"))) {
         Log::log(msg, category);
     }
+    if (type == QtFatalMsg && sWritingLog) {
+        // The default handler aborts.
+        sWritingLog->flush();
+    }
     sDefaultMessageHandler(type, context, msg);
 }
 
@@ -56,11 +76,227 @@ using namespace Disman;
 class Q_DECL_HIDDEN Log::Private
 {
 public:
+    struct Entry {
+        qint64 time;
+        QString category;
+        QString context;
+        QString message;
+
+        // Snapshot of a config to append to the message.
+        ConfigSnapshot config;
+    };
+
+    struct Snapshot {
+        uint64_t id{0};
+        ConfigSnapshot config;
+        QString text;
+    };
+
+    /// Formats the config of @p entry or references an earlier snapshot of it.
+    QString format_config(Entry const& entry, QByteArray& capture);
+
+    void enqueue(Entry&& entry);
+    void flush();
+    void run_writer();
+    void write(std::vector<Entry> const& entries, uint64_t dropped);
+    void stop_writer();
+
     QString context;
     bool enabled = false;
     QString file;
+    QString capture_file;
+
+    // Caps memory use when the writer falls behind, for example on a hanging file system.
+    static constexpr size_t max_queued_bytes = 4 * 1024 * 1024;
+    // The writer wakes up early when this much is queued.
+    static constexpr size_t batch_bytes = 64 * 1024;
+    static constexpr std::chrono::seconds batch_interval{1};
+
+    std::mutex mutex;
+    std::condition_variable wake_writer;
+    std::condition_variable written;
+
+    std::vector<Entry> queue;
+    size_t queued_bytes{0};
+    uint64_t dropped{0};
+    uint64_t enqueued_count{0};
+    uint64_t written_count{0};
+    bool flush_requested{false};
+    bool stopping{false};
+
+    std::thread writer;
+
+    // Only accessed by the writer thread.
+    Snapshot last_snapshot;
 };
 
+void Log::Private::enqueue(Entry&& entry)
+{
+    auto size = static_cast<size_t>(entry.message.size() + entry.context.size()
+                                    + entry.category.size())
+        * sizeof(QChar);
+    if (!entry.config.is_null()) {
+        // Rough estimate of a config snapshot.
+        size += 1024 * (entry.config.outputs().size() + 1);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queued_bytes + size > max_queued_bytes) {
+        dropped++;
+        return;
+    }
+
+    queue.push_back(std::move(entry));
+    queued_bytes += size;
+    enqueued_count++;
+
+    if (queued_bytes >= batch_bytes) {
+        wake_writer.notify_one();
+    }
+}
+
+void Log::Private::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!writer.joinable()) {
+        return;
+    }
+    if (std::this_thread::get_id() == writer.get_id()) {
+        // A fatal message on the writer thread. It can not wait for itself.
+        return;
+    }
+
+    auto const target = enqueued_count;
+    flush_requested = true;
+    wake_writer.notify_one();
+    written.wait(lock, [this, target] { return written_count >= target || stopping; });
+}
+
+void Log::Private::run_writer()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wake_writer.wait_for(lock, batch_interval, [this] {
+            return stopping || flush_requested || queued_bytes >= batch_bytes;
+        });
+
+        if (queue.empty() && !dropped) {
+            flush_requested = false;
+            written.notify_all();
+            if (stopping) {
+                return;
+            }
+            continue;
+        }
+
+        std::vector<Entry> entries;
+        entries.swap(queue);
+        auto const dropped_now = dropped;
+        auto const count = enqueued_count;
+        queued_bytes = 0;
+        dropped = 0;
+        flush_requested = false;
+
+        lock.unlock();
+        write(entries, dropped_now);
+        lock.lock();
+
+        written_count = count;
+        written.notify_all();
+    }
+}
+
+QString Log::Private::format_config(Entry const& entry, QByteArray& capture)
+{
+    auto const capturing = !capture_file.isEmpty();
+
+    if (!last_snapshot.config.is_null() && entry.config.compare(last_snapshot.config)) {
+        return QStringLiteral(" [config #%1, unchanged]").arg(last_snapshot.id);
+    }
+
+    last_snapshot.id++;
+    last_snapshot.config = entry.config;
+
+    if (capturing) {
+        QCborMap record;
+        record[QStringLiteral("id")] = static_cast<qint64>(last_snapshot.id);
+        record[QStringLiteral("time")] = entry.time;
+        record[QStringLiteral("config")]
+            = QCborValue::fromJsonValue(ConfigSerializer::serialize_config(entry.config));
+        capture += record.toCborValue().toCbor();
+
+        last_snapshot.text.clear();
+        return QStringLiteral(" [config #%1, captured]").arg(last_snapshot.id);
+    }
+
+    // The config is only owned by the writer thread.
+    last_snapshot.text = QString::fromStdString(entry.config.to_config()->log());
+    return QStringLiteral(" [config #%1]\n%2").arg(last_snapshot.id).arg(last_snapshot.text);
+}
+
+void Log::Private::write(std::vector<Entry> const& entries, uint64_t dropped_count)
+{
+    // The file is opened per batch so it can be moved or removed while we are running.
+    QFile log_file(file);
+    if (!log_file.open(QIODevice::Append | QIODevice::Text)) {
+        return;
+    }
+
+    QString text;
+    QByteArray capture;
+
+    for (auto const& entry : entries) {
+        auto message = entry.message;
+        if (!entry.config.is_null()) {
+            message += format_config(entry, capture);
+        }
+
+        auto const timestamp = QDateTime::fromMSecsSinceEpoch(entry.time).toString(
+            QStringLiteral("dd.MM.yyyy hh:mm:ss.zzz"));
+        text += QStringLiteral("\n%1 ; %2 ; %3 : %4")
+                    .arg(timestamp, entry.category, entry.context, message);
+    }
+
+    if (!capture.isEmpty()) {
+        QFile capture_out(capture_file);
+        if (capture_out.open(QIODevice::Append)) {
+            capture_out.write(capture);
+        }
+    }
+    if (dropped_count) {
+        text += QStringLiteral("\n%1 ; log ; : %2 messages dropped because the queue was full")
+                    .arg(QDateTime::currentDateTime().toString(
+                             QStringLiteral("dd.MM.yyyy hh:mm:ss.zzz")),
+                         QString::number(dropped_count));
+    }
+
+    log_file.write(text.toUtf8());
+}
+
+void Log::Private::stop_writer()
+{
+    if (!writer.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake_writer.notify_one();
+    writer.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    written.notify_all();
+}
+
+static void flush_on_exit()
+{
+    if (sWritingLog) {
+        sWritingLog->flush();
+    }
+}
+
 Log::Log()
     : d(new Private)
 {
@@ -85,6 +321,20 @@ Log::Log()
         qWarning() << "Failed to create logging dir" << fi.absolutePath();
     }
 
+    auto const capture_env = qgetenv("DISMAN_LOGGING_CAPTURE");
+    if (capture_env == "1" || capture_env.toLower() == "true") {
+        d->capture_file = fi.absolutePath() + QLatin1String("/disman.capture");
+    }
+
+    d->writer = std::thread([this] { d->run_writer(); });
+    sWritingLog = this;
+
+    static bool post_routine_added = false;
+    if (!post_routine_added) {
+        qAddPostRoutine(flush_on_exit);
+        post_routine_added = true;
+    }
+
     if (!sDefaultMessageHandler) {
         sDefaultMessageHandler = qInstallMessageHandler(dismanLogOutput);
     }
@@ -97,6 +347,11 @@ Log::Log(Log::Private* dd)
 
 Log::~Log()
 {
+    // Stopping the writer drains the queue.
+    d->stop_writer();
+    if (sWritingLog == this) {
+        sWritingLog = nullptr;
+    }
     delete d;
     sInstance = nullptr;
 }
@@ -121,6 +376,47 @@ QString Log::file() const
     return d->file;
 }
 
+void Log::log_config(QLoggingCategory const& category,
+                     QString const& msg,
+                     ConfigPtr const& config)
+{
+    // Direct calls skip the check of DISMAN_LOG_CONFIG. Formatting a config is not for free.
+    if (!category.isDebugEnabled()) {
+        return;
+    }
+    if (!config || !instance()->enabled() || !sDefaultMessageHandler) {
+        QMessageLogger().debug(category).noquote() << msg << config;
+        return;
+    }
+
+    ConfigSnapshot snapshot(config);
+
+    // Forwarded right away to stay in order with other output. Only the log file gets the
+    // formatted config, that is done on the writer thread.
+    QMessageLogContext log_context;
+    log_context.category = category.categoryName();
+    sDefaultMessageHandler(QtDebugMsg,
+                           log_context,
+                           msg
+                               + QStringLiteral(" [config with %1 outputs in %2]")
+                                     .arg(snapshot.outputs().size())
+                                     .arg(instance()->file()));
+
+    auto _cat = QString::fromLatin1(category.categoryName());
+    _cat.remove(QStringLiteral("disman."));
+
+    instance()->d->enqueue({QDateTime::currentMSecsSinceEpoch(),
+                            _cat,
+                            instance()->context(),
+                            msg,
+                            std::move(snapshot)});
+}
+
+void Log::flush()
+{
+    d->flush();
+}
+
 void Log::log(const QString& msg, const QString& category)
 {
     if (!instance()->enabled()) {
@@ -128,15 +424,10 @@ void Log::log(const QString& msg, const QString& category)
     }
     auto _cat = category;
     _cat.remove(QStringLiteral("disman."));
-    const QString timestamp
-        = QDateTime::currentDateTime().toString(QStringLiteral("dd.MM.yyyy hh:mm:ss.zzz"));
-    QString logMessage
-        = QStringLiteral("\n%1 ; %2 ; %3 : %4").arg(timestamp, _cat, instance()->context(), msg);
-    QFile file(instance()->file());
-    if (!file.open(QIODevice::Append | QIODevice::Text)) {
-        return;
-    }
-    file.write(logMessage.toUtf8());
+
+    // Formatting and writing happens on the writer thread.
+    instance()->d->enqueue(
+        {QDateTime::currentMSecsSinceEpoch(), _cat, instance()->context(), msg});
 }
 
 } // ns
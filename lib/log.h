@@ -44,6 +44,15 @@ void log(const QString& msg);
  * Please do not translate messages written to the logs, it's developer information and should be
  * english, independent from the user's locale preferences.
  *
+ * Messages are queued in memory and written by a background thread in batches, at the latest
+ * after one second. If the queue exceeds its size limit further messages are dropped and their
+ * number is noted in the log. The queue is flushed synchronously on exit and on fatal messages.
+ *
+ * Configs should be logged with DISMAN_LOG_CONFIG. They are then formatted on the writer thread
+ * and numbered, so an unchanged config is only printed once. With DISMAN_LOGGING_CAPTURE=true
+ * configs are not formatted at all but written in binary form to disman.capture next to the log
+ * file, and the log only references them by number.
+ *
  * @code
  *
  * Log::instance()->set_context("resume");
@@ -68,6 +77,20 @@ public:
      */
     static void log(const QString& msg, const QString& category = QString());
 
+    /** Log a config as debug message to @p category
+     *
+     * If file logging is enabled a snapshot of the config is formatted later by the writer
+     * thread. The default message handler then only receives the message with a reference to the
+     * log file. Otherwise the config is formatted directly. Nothing is formatted when debug output
+     * of @p category is disabled. Use the DISMAN_LOG_CONFIG macro, that skips the call then.
+     *
+     * @arg category The category to log to.
+     * @arg msg The log message to prefix the config with.
+     * @arg config The config to log.
+     */
+    static void
+    log_config(QLoggingCategory const& category, QString const& msg, ConfigPtr const& config);
+
     /** Context for the logs.
      *
      * The context can be used to indicate what is going on overall, it is used to be able
@@ -102,6 +125,12 @@ public:
      */
     QString file() const;
 
+    /** Write all queued messages to the file
+     *
+     * Blocks until the background writer has written all messages logged before this call.
+     */
+    void flush();
+
 private:
     explicit Log();
     class Private;
@@ -113,4 +142,11 @@ private:
 
 }
 
+#define DISMAN_LOG_CONFIG(category, msg, config)                                                   \
+    do {                                                                                           \
+        if (category().isDebugEnabled()) {                                                         \
+            Disman::Log::log_config(category(), msg, config);                                      \
+        }                                                                                          \
+    } while (false)
+
 #endif
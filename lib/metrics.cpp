@@ -0,0 +1,129 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "metrics.h"
+
+#include <QVariantList>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace Disman::Metrics
+{
+
+namespace
+{
+
+struct Histogram {
+    // Up to 2^24 µs, that is about 17 seconds. Longer durations go into the last bucket.
+    std::array<uint64_t, 25> buckets{};
+    uint64_t count{0};
+    uint64_t sum_us{0};
+    uint64_t max_us{0};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::map<QString, uint64_t> counters;
+    std::map<QString, Histogram> histograms;
+};
+
+Registry& registry()
+{
+    static Registry registry;
+    return registry;
+}
+
+}
+
+void count(QString const& name, uint64_t value)
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.counters[name] += value;
+}
+
+void record(QString const& name, std::chrono::nanoseconds duration)
+{
+    auto const us_signed = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    auto const us = static_cast<uint64_t>(std::max<int64_t>(0, us_signed));
+
+    size_t bucket = 0;
+    while (bucket + 1 < Histogram().buckets.size() && (uint64_t(1) << bucket) < us) {
+        bucket++;
+    }
+
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto& histogram = reg.histograms[name];
+    histogram.buckets[bucket]++;
+    histogram.count++;
+    histogram.sum_us += us;
+    histogram.max_us = std::max(histogram.max_us, us);
+}
+
+QVariantMap snapshot()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    QVariantMap counters;
+    for (auto const& [name, value] : reg.counters) {
+        counters.insert(name, static_cast<qulonglong>(value));
+    }
+
+    QVariantMap histograms;
+    for (auto const& [name, histogram] : reg.histograms) {
+        QVariantList buckets;
+        for (auto bucket : histogram.buckets) {
+            buckets << static_cast<qulonglong>(bucket);
+        }
+        histograms.insert(name,
+                          QVariantMap({
+                              {QStringLiteral("count"), static_cast<qulonglong>(histogram.count)},
+                              {QStringLiteral("sum-us"), static_cast<qulonglong>(histogram.sum_us)},
+                              {QStringLiteral("max-us"), static_cast<qulonglong>(histogram.max_us)},
+                              {QStringLiteral("buckets"), buckets},
+                          }));
+    }
+
+    return {{QStringLiteral("counters"), counters}, {QStringLiteral("histograms"), histograms}};
+}
+
+uint64_t percentile_us(QVariantMap const& histogram, double p)
+{
+    auto const count = histogram.value(QStringLiteral("count")).toULongLong();
+    auto const max_us = histogram.value(QStringLiteral("max-us")).toULongLong();
+    if (!count) {
+        return 0;
+    }
+
+    auto const buckets = histogram.value(QStringLiteral("buckets")).toList();
+    uint64_t sum = 0;
+    for (int i = 0; i + 1 < buckets.size(); i++) {
+        sum += buckets.at(i).toULongLong();
+        if (sum >= p * count) {
+            // The bound is never more than the largest recorded duration.
+            return std::min(uint64_t(1) << i, max_us);
+        }
+    }
+    return max_us;
+}
+
+Timer::Timer(QString name)
+    : m_name{std::move(name)}
+    , m_start{std::chrono::steady_clock::now()}
+{
+}
+
+Timer::~Timer()
+{
+    record(m_name, std::chrono::steady_clock::now() - m_start);
+}
+
+}
@@ -0,0 +1,57 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include "disman_export.h"
+
+#include <QString>
+#include <QVariantMap>
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Process-wide counters and duration histograms.
+ *
+ * The backend service exports them through the org.kwinft.disman.metrics D-Bus interface. They
+ * are updated on configuration changes only, so a mutex guards them.
+ */
+namespace Disman::Metrics
+{
+
+DISMAN_EXPORT void count(QString const& name, uint64_t value = 1);
+DISMAN_EXPORT void record(QString const& name, std::chrono::nanoseconds duration);
+
+/**
+ * All metrics as a map with the keys "counters" and "histograms". Histograms are maps with
+ * "count", "sum-us", "max-us" and "buckets". The n-th bucket holds durations up to 2^n µs.
+ */
+DISMAN_EXPORT QVariantMap snapshot();
+
+/**
+ * The upper bound of the bucket that contains the @p p quantile of a histogram from snapshot,
+ * with @p p between 0 and 1. The last bucket has no upper bound, the maximum is returned for it.
+ *
+ * @return duration in µs or 0 for an empty histogram
+ */
+DISMAN_EXPORT uint64_t percentile_us(QVariantMap const& histogram, double p);
+
+/// Records the time until destruction into a histogram.
+class DISMAN_EXPORT Timer
+{
+public:
+    explicit Timer(QString name);
+    ~Timer();
+
+    Timer(Timer const&) = delete;
+    Timer& operator=(Timer const&) = delete;
+
+private:
+    QString m_name;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+}
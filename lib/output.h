@@ -336,6 +336,7 @@ private:
 
     Output(Private* dd);
 
+    friend class ConfigSnapshot;
     friend class Generator;
 };
 
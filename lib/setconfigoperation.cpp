@@ -42,11 +42,19 @@ public:
     explicit SetConfigOperationPrivate(const Disman::ConfigPtr& config, ConfigOperation* qq);
 
     void backend_ready(org::kwinft::disman::backend* backend) override;
+    void send();
     void onConfigSet(QDBusPendingCallWatcher* watcher);
+    void complete();
+    void release();
     void normalizeOutputPositions();
 
     Disman::ConfigPtr config;
 
+    // For out-of-process
+    QPointer<org::kwinft::disman::backend> backend;
+    QList<QPointer<SetConfigOperation>> superseded_ops;
+    bool superseded{false};
+
 private:
     Q_DECLARE_PUBLIC(SetConfigOperation)
 };
@@ -70,11 +78,40 @@ void SetConfigOperationPrivate::backend_ready(org::kwinft::disman::backend* back
         q->emit_result();
         return;
     }
+    this->backend = backend;
+
+    auto manager = BackendManager::instance();
+    if (!manager->m_set_op_in_flight) {
+        manager->m_set_op_in_flight = q;
+        send();
+        return;
+    }
+
+    // Another operation is in flight. Wait for it, replacing any other waiting operation since
+    // only the latest config is of interest.
+    if (auto queued = manager->m_set_op_queued) {
+        auto queued_d = queued->d_func();
+        superseded_ops.append(queued);
+        superseded_ops.append(queued_d->superseded_ops);
+        queued_d->superseded_ops.clear();
+    }
+    manager->m_set_op_queued = q;
+}
+
+void SetConfigOperationPrivate::send()
+{
+    Q_Q(SetConfigOperation);
+
+    if (!backend) {
+        q->set_error(tr("Backend went away"));
+        complete();
+        return;
+    }
 
     const QVariantMap map = ConfigSerializer::serialize_config(config).toVariantMap();
     if (map.isEmpty()) {
         q->set_error(tr("Failed to serialize request"));
-        q->emit_result();
+        complete();
         return;
     }
 
@@ -92,7 +129,7 @@ void SetConfigOperationPrivate::onConfigSet(QDBusPendingCallWatcher* watcher)
 
     if (reply.isError()) {
         q->set_error(reply.error().message());
-        q->emit_result();
+        complete();
         return;
     }
 
@@ -101,7 +138,48 @@ void SetConfigOperationPrivate::onConfigSet(QDBusPendingCallWatcher* watcher)
         q->set_error(tr("Failed to deserialize backend response"));
     }
 
+    complete();
+}
+
+void SetConfigOperationPrivate::complete()
+{
+    Q_Q(SetConfigOperation);
+
+    for (auto const& op : qAsConst(superseded_ops)) {
+        if (!op) {
+            continue;
+        }
+        auto op_d = op->d_func();
+        op_d->config = config ? config->clone() : nullptr;
+        op_d->superseded = true;
+        op->set_error(q->error_string());
+        op->emit_result();
+    }
+    superseded_ops.clear();
+
     q->emit_result();
+    release();
+}
+
+void SetConfigOperationPrivate::release()
+{
+    Q_Q(SetConfigOperation);
+    auto manager = BackendManager::instance();
+
+    if (manager->m_set_op_queued == q) {
+        manager->m_set_op_queued.clear();
+        return;
+    }
+    if (manager->m_set_op_in_flight != q) {
+        return;
+    }
+
+    manager->m_set_op_in_flight.clear();
+    if (auto next = manager->m_set_op_queued) {
+        manager->m_set_op_queued.clear();
+        manager->m_set_op_in_flight = next;
+        next->d_func()->send();
+    }
 }
 
 SetConfigOperation::SetConfigOperation(const ConfigPtr& config, QObject* parent)
@@ -111,6 +189,23 @@ SetConfigOperation::SetConfigOperation(const ConfigPtr& config, QObject* parent)
 
 SetConfigOperation::~SetConfigOperation()
 {
+    Q_D(SetConfigOperation);
+
+    if (BackendManager::instance()->method() == BackendManager::InProcess) {
+        return;
+    }
+
+    // Operations replaced by this one would otherwise never finish.
+    for (auto const& op : qAsConst(d->superseded_ops)) {
+        if (!op) {
+            continue;
+        }
+        op->d_func()->superseded = true;
+        op->set_error(tr("Superseding operation was deleted"));
+        op->emit_result();
+    }
+    d->superseded_ops.clear();
+    d->release();
 }
 
 ConfigPtr SetConfigOperation::config() const
@@ -119,14 +214,22 @@ ConfigPtr SetConfigOperation::config() const
     return d->config;
 }
 
+bool SetConfigOperation::superseded() const
+{
+    Q_D(const SetConfigOperation);
+    return d->superseded;
+}
+
 void SetConfigOperation::start()
 {
     Q_D(SetConfigOperation);
     d->normalizeOutputPositions();
     if (BackendManager::instance()->method() == BackendManager::InProcess) {
-        auto backend = d->loadBackend();
-        backend->set_config(d->config);
-        emit_result();
+        d->with_backend([this](Backend* backend) {
+            Q_D(SetConfigOperation);
+            backend->set_config(d->config);
+            emit_result();
+        });
     } else {
         d->request_backend();
     }
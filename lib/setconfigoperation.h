@@ -28,6 +28,13 @@ namespace Disman
 
 class SetConfigOperationPrivate;
 
+/**
+ * Sets a config on the backend.
+ *
+ * With an out-of-process backend at most one set operation per client is sent to the backend at
+ * a time. Operations started in the meantime are queued and only the most recent one of them is
+ * sent once the current one has finished. The ones replaced by it finish together with it.
+ */
 class DISMAN_EXPORT SetConfigOperation : public Disman::ConfigOperation
 {
     Q_OBJECT
@@ -37,6 +44,15 @@ public:
 
     Disman::ConfigPtr config() const override;
 
+    /**
+     * Indicates that this operation was replaced by a newer one before its config was sent to
+     * the backend. The config and error state of this operation are then the result of the
+     * newer operation.
+     *
+     * @return true if superseded by a newer operation
+     */
+    bool superseded() const;
+
 protected:
     void start() override;
 
@@ -0,0 +1,227 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "trace.h"
+
+#include "disman_debug.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Disman::Trace
+{
+
+namespace
+{
+
+QString trace_directory()
+{
+    auto const env = qEnvironmentVariable("DISMAN_TRACE");
+    if (env.isEmpty() || env == QLatin1String("0") || env == QLatin1String("false")) {
+        return QString();
+    }
+    if (env == QLatin1String("1") || env == QLatin1String("true")) {
+        return QDir::tempPath();
+    }
+    return env;
+}
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * A recorded span. The sequence is odd while the record is written and afterwards twice the
+ * number of records written to the ring so far. Other threads read the fields only when the
+ * sequence is even and unchanged before and after reading. The fields are atomics so that torn
+ * records can be detected without a data race.
+ */
+struct Record {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<char const*> name{nullptr};
+    std::atomic<uint64_t> trace_id{0};
+    std::atomic<int64_t> begin_ns{0};
+    std::atomic<int64_t> end_ns{0};
+};
+
+/**
+ * Spans of one thread. Only the owning thread writes to it, so recording needs no lock. When the
+ * buffer is full the oldest spans are overwritten.
+ */
+struct Ring {
+    static constexpr size_t size = 8192;
+
+    std::array<Record, size> records;
+    std::atomic<uint64_t> count{0};
+    int tid;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+};
+
+Registry& registry()
+{
+    static Registry registry;
+    return registry;
+}
+
+Ring& thread_ring()
+{
+    // The registry keeps rings of finished threads alive so their spans are still dumped.
+    thread_local std::shared_ptr<Ring> ring = [] {
+        static std::once_flag post_routine;
+        std::call_once(post_routine, [] { qAddPostRoutine(dump); });
+
+        auto ring = std::make_shared<Ring>();
+        auto& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        ring->tid = static_cast<int>(reg.rings.size()) + 1;
+        reg.rings.push_back(ring);
+        return ring;
+    }();
+    return *ring;
+}
+
+thread_local uint64_t s_current_id{0};
+
+}
+
+namespace detail
+{
+bool enabled = !trace_directory().isEmpty();
+}
+
+uint64_t start_trace()
+{
+    if (!detail::enabled) {
+        return 0;
+    }
+
+    // The process id in the upper half keeps ids unique across processes.
+    static std::atomic<uint32_t> counter{0};
+    s_current_id = (static_cast<uint64_t>(QCoreApplication::applicationPid()) << 32)
+        | ++counter;
+    return s_current_id;
+}
+
+uint64_t current_id()
+{
+    return s_current_id;
+}
+
+void set_current_id(uint64_t id)
+{
+    s_current_id = id;
+}
+
+void Span::begin()
+{
+    m_begin_ns = now_ns();
+}
+
+void Span::end()
+{
+    auto& ring = thread_ring();
+    auto const index = ring.count.load(std::memory_order_relaxed);
+    auto& record = ring.records[index % Ring::size];
+
+    record.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    record.name.store(m_name, std::memory_order_relaxed);
+    record.trace_id.store(s_current_id, std::memory_order_relaxed);
+    record.begin_ns.store(m_begin_ns, std::memory_order_relaxed);
+    record.end_ns.store(now_ns(), std::memory_order_relaxed);
+
+    record.sequence.store(2 * index + 2, std::memory_order_release);
+    ring.count.store(index + 1, std::memory_order_release);
+}
+
+void dump()
+{
+    if (!detail::enabled) {
+        return;
+    }
+
+    auto const pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    for (auto const& ring : reg.rings) {
+        auto const count = ring->count.load(std::memory_order_acquire);
+        auto const first = count > Ring::size ? count - Ring::size : 0;
+
+        for (auto i = first; i < count; i++) {
+            auto const& slot = ring->records[i % Ring::size];
+
+            // Other threads might still record spans. A record being written or already
+            // overwritten by a newer one is skipped.
+            auto const sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * i + 2) {
+                continue;
+            }
+            auto const name = slot.name.load(std::memory_order_relaxed);
+            auto const trace_id = slot.trace_id.load(std::memory_order_relaxed);
+            auto const begin_ns = slot.begin_ns.load(std::memory_order_relaxed);
+            auto const end_ns = slot.end_ns.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                continue;
+            }
+
+            QJsonObject event;
+            event[QStringLiteral("name")] = QString::fromLatin1(name);
+            event[QStringLiteral("cat")] = QStringLiteral("disman");
+            event[QStringLiteral("ph")] = QStringLiteral("X");
+            event[QStringLiteral("ts")] = begin_ns / 1000.;
+            event[QStringLiteral("dur")] = (end_ns - begin_ns) / 1000.;
+            event[QStringLiteral("pid")] = pid;
+            event[QStringLiteral("tid")] = ring->tid;
+            if (trace_id) {
+                event[QStringLiteral("args")] = QJsonObject(
+                    {{QStringLiteral("trace_id"), QString::number(trace_id, 16)}});
+            }
+            events.append(event);
+        }
+    }
+
+    auto name = QCoreApplication::applicationName();
+    if (name.isEmpty()) {
+        name = QStringLiteral("disman");
+    }
+
+    QFile file(QDir(trace_directory())
+                   .filePath(QStringLiteral("disman-trace-%1-%2.json").arg(name).arg(pid)));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(DISMAN) << "Failed to write trace to" << file.fileName();
+        return;
+    }
+
+    QJsonObject trace;
+    trace[QStringLiteral("traceEvents")] = events;
+    trace[QStringLiteral("displayTimeUnit")] = QStringLiteral("ms");
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    qCDebug(DISMAN) << "Trace written to" << file.fileName();
+}
+
+}
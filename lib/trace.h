@@ -0,0 +1,83 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include "disman_export.h"
+
+#include <QtGlobal>
+
+#include <cstdint>
+
+/**
+ * Scoped latency tracing across the service and client processes.
+ *
+ * Tracing is enabled by setting the environment variable DISMAN_TRACE. Its value is the directory
+ * the trace is written to when the process quits, or "1" for the temporary directory. The file
+ * is in the Chrome trace event format and can be opened in Perfetto or chrome://tracing. Traces
+ * of several processes can be loaded together since all use the monotonic clock.
+ *
+ * A trace id groups the spans caused by one event, for example an output being plugged in. It is
+ * stored per thread and transported between processes with serialized configs.
+ *
+ * When tracing is disabled a span costs a single branch.
+ */
+namespace Disman::Trace
+{
+
+namespace detail
+{
+DISMAN_EXPORT extern bool enabled;
+}
+
+inline bool enabled()
+{
+    return detail::enabled;
+}
+
+/// Starts a new trace on the current thread and returns its id or 0 if tracing is disabled.
+DISMAN_EXPORT uint64_t start_trace();
+
+DISMAN_EXPORT uint64_t current_id();
+DISMAN_EXPORT void set_current_id(uint64_t id);
+
+/// Writes the recorded spans. This is done automatically when the application quits.
+DISMAN_EXPORT void dump();
+
+class DISMAN_EXPORT Span
+{
+public:
+    /// @p name must outlive the process, usually it is a string literal.
+    explicit Span(char const* name)
+        : m_name{name}
+    {
+        if (Q_UNLIKELY(detail::enabled)) {
+            begin();
+        }
+    }
+    ~Span()
+    {
+        if (Q_UNLIKELY(m_begin_ns)) {
+            end();
+        }
+    }
+
+    Span(Span const&) = delete;
+    Span& operator=(Span const&) = delete;
+
+private:
+    void begin();
+    void end();
+
+    char const* m_name;
+    int64_t m_begin_ns{0};
+};
+
+}
+
+#define DISMAN_TRACE_CONCAT_IMPL(a, b) a##b
+#define DISMAN_TRACE_CONCAT(a, b) DISMAN_TRACE_CONCAT_IMPL(a, b)
+#define DISMAN_TRACE_SPAN(name)                                                                    \
+    Disman::Trace::Span DISMAN_TRACE_CONCAT(disman_trace_span_, __LINE__)(name)
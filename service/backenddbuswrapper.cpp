@@ -18,29 +18,29 @@
  */
 #include "backenddbuswrapper.h"
 #include "backendadaptor.h"
-#include "backendloader.h"
 #include "disman_backend_launcher_debug.h"
 
-#include "backend.h"
 #include "config.h"
 #include "configserializer_p.h"
+#include "metrics.h"
+#include "trace.h"
 
 #include <QDBusConnection>
 #include <QDBusError>
+#include <QJsonDocument>
 
-BackendDBusWrapper::BackendDBusWrapper(Disman::Backend* backend)
+BackendDBusWrapper::BackendDBusWrapper(BackendWorker* worker)
     : QObject()
-    , mBackend(backend)
+    , m_worker(worker)
+    , mChangeCollector(new QTimer(this))
 {
-    connect(mBackend,
-            &Disman::Backend::config_changed,
-            this,
-            &BackendDBusWrapper::backendConfigChanged);
-
-    mChangeCollector.setSingleShot(true);
-    mChangeCollector.setInterval(200); // wait for 200 msecs without any change
-                                       // before actually emitting configChanged
-    connect(&mChangeCollector, &QTimer::timeout, this, &BackendDBusWrapper::doEmitConfigChanged);
+    // Created here so it moves along with us to the front thread.
+    new BackendAdaptor(this);
+
+    mChangeCollector->setSingleShot(true);
+    mChangeCollector->setInterval(200); // wait for 200 msecs without any change
+                                        // before actually emitting configChanged
+    connect(mChangeCollector, &QTimer::timeout, this, &BackendDBusWrapper::doEmitConfigChanged);
 }
 
 BackendDBusWrapper::~BackendDBusWrapper()
@@ -50,7 +50,6 @@ BackendDBusWrapper::~BackendDBusWrapper()
 bool BackendDBusWrapper::init()
 {
     QDBusConnection dbus = QDBusConnection::sessionBus();
-    new BackendAdaptor(this);
     if (!dbus.registerObject(QStringLiteral("/backend"), this, QDBusConnection::ExportAdaptors)) {
         qCWarning(DISMAN_BACKEND_LAUNCHER)
             << "Failed to export backend to DBus: another launcher already running?";
@@ -61,61 +60,134 @@ bool BackendDBusWrapper::init()
     return true;
 }
 
-QVariantMap BackendDBusWrapper::getConfig() const
+QVariantMap BackendDBusWrapper::getConfig()
 {
-    auto const config = mBackend->config();
-    assert(config != nullptr);
-    if (!config) {
-        qCWarning(DISMAN_BACKEND_LAUNCHER) << "Backend provided an empty config!";
-        return QVariantMap();
+    Q_EMIT activity();
+
+    if (!m_config.is_null()) {
+        return serialize();
     }
 
-    const QJsonObject obj = Disman::ConfigSerializer::serialize_config(mBackend->config());
-    Q_ASSERT(!obj.isEmpty());
-    return obj.toVariantMap();
+    // Nothing published yet. The worker builds the config and we answer when it is published.
+    setDelayedReply(true);
+    m_pending_reads.push_back({connection(), message()});
+    if (m_pending_reads.size() == 1) {
+        QMetaObject::invokeMethod(
+            m_worker, [worker = m_worker] { worker->request_config(); }, Qt::QueuedConnection);
+    }
+    return QVariantMap();
 }
 
 QVariantMap BackendDBusWrapper::setConfig(const QVariantMap& configMap)
 {
+    Q_EMIT activity();
+
     if (configMap.isEmpty()) {
         qCWarning(DISMAN_BACKEND_LAUNCHER) << "Received an empty config map";
         return QVariantMap();
     }
 
     const Disman::ConfigPtr config = Disman::ConfigSerializer::deserialize_config(configMap);
-    mBackend->set_config(config);
+    if (!config) {
+        qCWarning(DISMAN_BACKEND_LAUNCHER) << "Received a config map that can not be deserialized";
+        sendErrorReply(QDBusError::InvalidArgs, QStringLiteral("Invalid config"));
+        return QVariantMap();
+    }
+
+    // The client's config carries the id of the last change it has seen. A request is a new cause.
+    auto const trace_id = Disman::Trace::start_trace();
+
+    setDelayedReply(true);
+    QMetaObject::invokeMethod(
+        m_worker,
+        [worker = m_worker,
+         snapshot = Disman::ConfigSnapshot(config),
+         call = PendingCall{connection(), message()},
+         trace_id] { worker->apply(snapshot, call, trace_id); },
+        Qt::QueuedConnection);
+    return QVariantMap();
+}
 
-    mCurrentConfig = mBackend->config();
-    QMetaObject::invokeMethod(this, "doEmitConfigChanged", Qt::QueuedConnection);
+void BackendDBusWrapper::publish(Disman::ConfigSnapshot const& config, uint64_t trace_id)
+{
+    m_config = config;
+    m_trace_id = trace_id;
+    m_serialized_map.clear();
 
-    // TODO: set_config should return adjusted config that was actually applied
-    const QJsonObject obj = Disman::ConfigSerializer::serialize_config(mCurrentConfig);
-    Q_ASSERT(!obj.isEmpty());
-    return obj.toVariantMap();
+    auto const map = m_config.is_null() ? QVariantMap() : serialize();
+    for (auto const& call : m_pending_reads) {
+        call.connection.send(call.message.createReply(map));
+    }
+    m_pending_reads.clear();
 }
 
-void BackendDBusWrapper::backendConfigChanged(const Disman::ConfigPtr& config)
+void BackendDBusWrapper::publish_change(Disman::ConfigSnapshot const& config, uint64_t trace_id)
 {
-    assert(config != nullptr);
-    if (!config) {
-        qCWarning(DISMAN_BACKEND_LAUNCHER) << "Backend provided an empty config!";
-        return;
+    Q_EMIT activity();
+    publish(config, trace_id);
+
+    if (!mChangeCollector->isActive()) {
+        m_collect_start = std::chrono::steady_clock::now();
+    }
+    m_change_pending = true;
+    mChangeCollector->start();
+}
+
+void BackendDBusWrapper::publish_applied(Disman::ConfigSnapshot const& config,
+                                         uint64_t trace_id,
+                                         std::vector<PendingCall> const& calls)
+{
+    publish(config, trace_id);
+    for (auto const& call : calls) {
+        reply(call);
     }
 
-    mCurrentConfig = config;
-    mChangeCollector.start();
+    // The change signal reuses the serialization of the reply.
+    m_change_pending = true;
+    doEmitConfigChanged();
+}
+
+void BackendDBusWrapper::reply(PendingCall const& call)
+{
+    call.connection.send(call.message.createReply(serialize()));
+}
+
+QVariantMap BackendDBusWrapper::serialize()
+{
+    // The same config is usually sent several times, as replies and in the change signal.
+    if (m_serialized_map.isEmpty()) {
+        Disman::Trace::set_current_id(m_trace_id);
+
+        auto const obj = Disman::ConfigSerializer::serialize_config(m_config);
+        Q_ASSERT(!obj.isEmpty());
+
+        // Once per published config. The D-Bus message is smaller than the compact JSON but grows
+        // with it.
+        Disman::Metrics::count(QStringLiteral("configs-serialized"));
+        Disman::Metrics::count(QStringLiteral("serialized-bytes"),
+                               QJsonDocument(obj).toJson(QJsonDocument::Compact).size());
+        m_serialized_map = obj.toVariantMap();
+    }
+    return m_serialized_map;
 }
 
 void BackendDBusWrapper::doEmitConfigChanged()
 {
-    assert(mCurrentConfig != nullptr);
-    if (!mCurrentConfig) {
+    if (!m_change_pending || m_config.is_null()) {
         return;
     }
 
-    const QJsonObject obj = Disman::ConfigSerializer::serialize_config(mCurrentConfig);
-    Q_EMIT configChanged(obj.toVariantMap());
+    DISMAN_TRACE_SPAN("BackendDBusWrapper::doEmitConfigChanged");
+
+    if (m_collect_start != std::chrono::steady_clock::time_point()) {
+        Disman::Metrics::record(QStringLiteral("change-collector-wait"),
+                                std::chrono::steady_clock::now() - m_collect_start);
+        m_collect_start = {};
+    }
+
+    Q_EMIT configChanged(serialize());
+    Disman::Metrics::count(QStringLiteral("config-changed-emitted"));
 
-    mCurrentConfig.reset();
-    mChangeCollector.stop();
+    m_change_pending = false;
+    mChangeCollector->stop();
 }
@@ -20,46 +20,69 @@
 #ifndef BACKENDDBUSWRAPPER_H
 #define BACKENDDBUSWRAPPER_H
 
+#include <QDBusContext>
 #include <QObject>
 #include <QTimer>
 
-#include "types.h"
+#include "backendworker.h"
+#include "configsnapshot.h"
 
-namespace Disman
-{
-class Backend;
-}
+#include <chrono>
+#include <vector>
 
-class BackendDBusWrapper : public QObject
+/**
+ * The D-Bus front of the backend. It runs on its own thread and answers config requests from the
+ * config the worker published last, so reads are not held up by the windowing system or the disk.
+ * Set requests are forwarded to the worker and answered once it published the result.
+ */
+class BackendDBusWrapper : public QObject, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kwinft.disman.backend")
 
 public:
-    explicit BackendDBusWrapper(Disman::Backend* backend);
+    explicit BackendDBusWrapper(BackendWorker* worker);
     ~BackendDBusWrapper() override;
 
     bool init();
 
-    QVariantMap getConfig() const;
+    QVariantMap getConfig();
     QVariantMap setConfig(const QVariantMap& config);
 
-    inline Disman::Backend* backend() const
-    {
-        return mBackend;
-    }
+    // Called by the worker through the event queue of the front thread.
+    void publish(Disman::ConfigSnapshot const& config, uint64_t trace_id);
+    void publish_change(Disman::ConfigSnapshot const& config, uint64_t trace_id);
+    void publish_applied(Disman::ConfigSnapshot const& config,
+                         uint64_t trace_id,
+                         std::vector<PendingCall> const& calls);
+    void reply(PendingCall const& call);
 
 Q_SIGNALS:
     void configChanged(const QVariantMap& config);
 
+    /// Emitted on any client request and backend change, without the D-Bus interface.
+    void activity();
+
 private Q_SLOTS:
-    void backendConfigChanged(const Disman::ConfigPtr& config);
     void doEmitConfigChanged();
 
 private:
-    Disman::Backend* mBackend = nullptr;
-    QTimer mChangeCollector;
-    Disman::ConfigPtr mCurrentConfig;
+    QVariantMap serialize();
+
+    BackendWorker* m_worker;
+    QTimer* mChangeCollector;
+    bool m_change_pending{false};
+
+    // When the change collector was started for the currently collected changes.
+    std::chrono::steady_clock::time_point m_collect_start;
+
+    // The config published last by the worker.
+    Disman::ConfigSnapshot m_config;
+    uint64_t m_trace_id{0};
+    QVariantMap m_serialized_map;
+
+    // Config requests received before the worker published a config.
+    std::vector<PendingCall> m_pending_reads;
 };
 
 #endif // BACKENDDBUSWRAPPER_H
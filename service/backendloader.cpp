@@ -21,14 +21,30 @@
 #include "backenddbuswrapper.h"
 #include "backendloaderadaptor.h"
 #include "backendmanager_p.h"
+#include "backendworker.h"
+#include "config.h"
+#include "configserializer_p.h"
 #include "disman_backend_launcher_debug.h"
+#include "metrics.h"
+#include "metricsadaptor.h"
 
 #include <QCoreApplication>
 #include <QDBusConnectionInterface>
+#include <QDBusServer>
+#include <QDBusServiceWatcher>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QPluginLoader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
 
 #include <memory>
+#include <utility>
 
 #include <QDBusConnection>
 #include <QDBusInterface>
@@ -42,6 +58,35 @@ void pluginDeleter(QPluginLoader* p)
     }
 }
 
+namespace
+{
+
+/// Files in the runtime directory survive the service but not the session.
+QString runtime_file_path(QString const& name)
+{
+    auto runtime_dir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtime_dir.isEmpty()) {
+        runtime_dir = QDir::tempPath();
+    }
+    auto path = runtime_dir + QLatin1Char('/') + name;
+    if (auto const instance = Disman::BackendManager::instance_name(); !instance.isEmpty()) {
+        path += QLatin1Char('-') + instance;
+    }
+    return path;
+}
+
+QString state_file_path()
+{
+    return runtime_file_path(QStringLiteral("disman-launcher-state"));
+}
+
+QString snapshot_file_path()
+{
+    return runtime_file_path(QStringLiteral("disman-snapshot"));
+}
+
+}
+
 BackendLoader::BackendLoader()
     : QObject()
     , QDBusContext()
@@ -52,7 +97,16 @@ BackendLoader::BackendLoader()
 
 BackendLoader::~BackendLoader()
 {
-    delete mBackend;
+    record_stop();
+
+    if (mBackend && !m_keep_snapshot) {
+        QFile::remove(snapshot_file_path());
+    }
+
+    for (auto const& name : qAsConst(m_peer_connections)) {
+        QDBusConnection::disconnectFromPeer(name);
+    }
+    destroy_backend();
     pluginDeleter(mLoader);
     qCDebug(DISMAN_BACKEND_LAUNCHER) << "Backend loader destroyed";
 }
@@ -61,6 +115,7 @@ bool BackendLoader::init()
 {
     QDBusConnection dbus = QDBusConnection::sessionBus();
     new BackendLoaderAdaptor(this);
+    new MetricsAdaptor(this);
     if (!dbus.registerObject(QStringLiteral("/"), this, QDBusConnection::ExportAdaptors)) {
         qCWarning(DISMAN_BACKEND_LAUNCHER)
             << "Failed to export backend to DBus: another launcher already running?";
@@ -68,13 +123,132 @@ bool BackendLoader::init()
         return false;
     }
 
+    record_start();
+    start_peer_server();
+    start_idle_timer();
     return true;
 }
 
-QString BackendLoader::backend() const
+void BackendLoader::record_start()
 {
+    // The state file survives the service but not the session. It contains the number of crashes
+    // so far and whether an instance is running. If one is marked as running at startup it has
+    // not shut down cleanly.
+    QFile file(state_file_path());
+    uint64_t restarts = 0;
+
+    if (file.open(QIODevice::ReadOnly)) {
+        auto const fields = file.readAll().trimmed().split(' ');
+        restarts = fields.value(0).toULongLong();
+        if (fields.value(1) == "running") {
+            restarts++;
+            qCWarning(DISMAN_BACKEND_LAUNCHER)
+                << "Previous service instance did not exit cleanly. Restarts:" << restarts;
+        }
+        file.close();
+    }
+
+    Disman::Metrics::count(QStringLiteral("crash-restarts"), restarts);
+
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QByteArray::number(static_cast<qulonglong>(restarts)) + " running\n");
+    }
+    m_state_recorded = true;
+}
+
+void BackendLoader::record_stop()
+{
+    if (!m_state_recorded) {
+        return;
+    }
+
+    QFile file(state_file_path());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    auto const restarts = file.readAll().trimmed().split(' ').value(0);
+    file.close();
+
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(restarts + " stopped\n");
+    }
+}
+
+void BackendLoader::start_peer_server()
+{
+    // Clients first discover us on the session bus and then switch over to a direct connection,
+    // so backend traffic does not need to pass through the bus daemon. Clients that do not
+    // support this, or if the server can not be started, keep talking over the session bus.
+    auto runtime_dir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtime_dir.isEmpty()) {
+        runtime_dir = QDir::tempPath();
+    }
+
+    m_peer_server = new QDBusServer(QStringLiteral("unix:tmpdir=") + runtime_dir, this);
+    if (!m_peer_server->isConnected()) {
+        qCWarning(DISMAN_BACKEND_LAUNCHER)
+            << "Failed to start peer-to-peer server:" << m_peer_server->lastError().message();
+        delete m_peer_server;
+        m_peer_server = nullptr;
+        return;
+    }
+
+    connect(m_peer_server,
+            &QDBusServer::newConnection,
+            this,
+            &BackendLoader::handle_peer_connection);
+    qCDebug(DISMAN_BACKEND_LAUNCHER) << "Peer-to-peer server listening on"
+                                     << m_peer_server->address();
+}
+
+void BackendLoader::handle_peer_connection(QDBusConnection connection)
+{
+    // QDBusServer does not tell us about closed connections. Prune them here instead.
+    prune_peer_connections();
+
+    qCDebug(DISMAN_BACKEND_LAUNCHER) << "New peer connection" << connection.name();
+    m_peer_connections.push_back(connection.name());
+
     if (mBackend) {
-        return mBackend->backend()->name();
+        connection.registerObject(
+            QStringLiteral("/backend"), mBackend, QDBusConnection::ExportAdaptors);
+    }
+}
+
+void BackendLoader::prune_peer_connections()
+{
+    auto it = m_peer_connections.begin();
+    while (it != m_peer_connections.end()) {
+        if (QDBusConnection(*it).isConnected()) {
+            ++it;
+            continue;
+        }
+        QDBusConnection::disconnectFromPeer(*it);
+        it = m_peer_connections.erase(it);
+    }
+}
+
+void BackendLoader::export_backend_to_peers()
+{
+    assert(mBackend);
+
+    for (auto const& name : qAsConst(m_peer_connections)) {
+        QDBusConnection connection(name);
+        if (!connection.isConnected()) {
+            continue;
+        }
+        connection.registerObject(
+            QStringLiteral("/backend"), mBackend, QDBusConnection::ExportAdaptors);
+    }
+}
+
+QString BackendLoader::backend() const
+{
+    if (m_worker) {
+        return m_worker->backend()->name();
+    }
+    if (m_loading_backend) {
+        return m_loading_backend->name();
     }
 
     return QString();
@@ -82,32 +256,108 @@ QString BackendLoader::backend() const
 
 bool BackendLoader::requestBackend(const QString& backendName, const QVariantMap& arguments)
 {
-    if (mBackend) {
+    if (m_idle_timer) {
+        m_idle_timer->start();
+        track_client();
+    }
+
+    if (auto const active = m_loading_backend ? m_loading_backend
+                                              : (m_worker ? m_worker->backend() : nullptr)) {
         // If an backend is already loaded, but it's not the same as the one
         // requested, then it's an error
-        if (!backendName.isEmpty() && mBackend->backend()->name() != backendName) {
+        if (!backendName.isEmpty() && active->name() != backendName) {
             sendErrorReply(QDBusError::Failed, QStringLiteral("Another backend is already active"));
             return false;
-        } else {
-            // If caller requested the same one as already loaded, or did not
-            // request a specific backend, hapilly reuse the existing one
-            return true;
         }
+        if (m_loading_backend) {
+            // Answered together with the first request when the backend is initialized.
+            setDelayedReply(true);
+            m_pending_requests.push_back({connection(), message()});
+            return false;
+        }
+        // If caller requested the same one as already loaded, or did not
+        // request a specific backend, hapilly reuse the existing one
+        return true;
     }
 
+    m_load_timer.start();
     auto backend = loadBackend(backendName, arguments);
     if (!backend) {
         return false;
     }
+    m_backend_arguments = arguments;
+
+    if (backend->initializing()) {
+        // Instead of blocking until the backend is connected to the windowing system we answer
+        // the request later. Queued so the backend can be unloaded in the handler.
+        m_loading_backend = backend;
+        connect(backend,
+                &Disman::Backend::init_finished,
+                this,
+                &BackendLoader::finish_backend_init,
+                Qt::QueuedConnection);
+        setDelayedReply(true);
+        m_pending_requests.push_back({connection(), message()});
+        return false;
+    }
+
+    return setup_backend(backend);
+}
+
+void BackendLoader::finish_backend_init()
+{
+    auto backend = std::exchange(m_loading_backend, nullptr);
+    assert(backend);
+    disconnect(backend, &Disman::Backend::init_finished, this, nullptr);
+
+    auto success = backend->valid();
+    if (success) {
+        success = setup_backend(backend);
+    } else {
+        qCDebug(DISMAN_BACKEND_LAUNCHER) << "Skipping" << backend->name() << "backend";
+        pluginDeleter(mLoader);
+        mLoader = nullptr;
+    }
+
+    for (auto const& call : m_pending_requests) {
+        call.connection.send(call.message.createReply(success));
+    }
+    m_pending_requests.clear();
+}
+
+bool BackendLoader::setup_backend(Disman::Backend* backend)
+{
+    m_worker = new BackendWorker(backend);
+    mBackend = new BackendDBusWrapper(m_worker);
+
+    m_front_thread = new QThread;
+    m_front_thread->setObjectName(QStringLiteral("disman-dbus-front"));
+    m_front_thread->start();
+    mBackend->moveToThread(m_front_thread);
+    m_worker->set_front(mBackend);
 
-    mBackend = new BackendDBusWrapper(backend);
     if (!mBackend->init()) {
-        delete mBackend;
-        mBackend = nullptr;
+        destroy_backend();
         pluginDeleter(mLoader);
         mLoader = nullptr;
         return false;
     }
+
+    // Requests the front received meanwhile reach the worker only after this.
+    m_worker->start(take_snapshot(backend->name(), m_backend_arguments));
+
+    // Checkpoint every settled change, so a restarted service can continue from it.
+    connect(mBackend, &BackendDBusWrapper::configChanged, this, [this] { save_snapshot(); });
+    if (m_idle_timer) {
+        connect(mBackend, &BackendDBusWrapper::activity, m_idle_timer, [this] {
+            m_idle_timer->start();
+        });
+    }
+
+    export_backend_to_peers();
+
+    qCDebug(DISMAN_BACKEND_LAUNCHER)
+        << "Backend" << backend->name() << "ready after" << m_load_timer.elapsed() << "ms.";
     return true;
 }
 
@@ -121,6 +371,173 @@ Disman::Backend* BackendLoader::loadBackend(const QString& name, const QVariantM
     return Disman::BackendManager::load_backend_plugin(mLoader, name, arguments);
 }
 
+void BackendLoader::destroy_backend()
+{
+    if (!mBackend) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // The worker must not post to the front anymore once it is gone.
+    m_worker->set_front(nullptr);
+    QMetaObject::invokeMethod(
+        mBackend, [front = mBackend] { delete front; }, Qt::BlockingQueuedConnection);
+    mBackend = nullptr;
+
+    m_front_thread->quit();
+    m_front_thread->wait();
+    delete m_front_thread;
+    m_front_thread = nullptr;
+
+    delete m_worker;
+    m_worker = nullptr;
+
+    qCDebug(DISMAN_BACKEND_LAUNCHER) << "Backend shut down after" << timer.elapsed() << "ms.";
+}
+
+void BackendLoader::start_idle_timer()
+{
+    bool ok;
+    auto const seconds = qEnvironmentVariableIntValue("DISMAN_IDLE_TIMEOUT", &ok);
+    if (!ok || seconds <= 0) {
+        return;
+    }
+
+    qCDebug(DISMAN_BACKEND_LAUNCHER) << "Quitting after" << seconds << "seconds without clients.";
+    m_idle_timer = new QTimer(this);
+    m_idle_timer->setInterval(seconds * 1000);
+    m_idle_timer->setSingleShot(true);
+    connect(m_idle_timer, &QTimer::timeout, this, &BackendLoader::handle_idle_timeout);
+    m_idle_timer->start();
+
+    // Clients restart the service right away when it leaves the bus. So it must not quit while
+    // any of them is still running, even when they are idle.
+    m_client_watcher = new QDBusServiceWatcher(this);
+    m_client_watcher->setConnection(QDBusConnection::sessionBus());
+    m_client_watcher->setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+    connect(m_client_watcher,
+            &QDBusServiceWatcher::serviceUnregistered,
+            this,
+            &BackendLoader::handle_client_gone);
+}
+
+void BackendLoader::track_client()
+{
+    if (!calledFromDBus()) {
+        return;
+    }
+
+    auto const service = message().service();
+    if (service.isEmpty() || m_client_watcher->watchedServices().contains(service)) {
+        return;
+    }
+
+    m_client_watcher->addWatchedService(service);
+
+    // The client may have left the bus before we started watching it.
+    if (!connection().interface()->isServiceRegistered(service)) {
+        m_client_watcher->removeWatchedService(service);
+    }
+}
+
+void BackendLoader::handle_client_gone(QString const& service)
+{
+    m_client_watcher->removeWatchedService(service);
+
+    if (m_client_watcher->watchedServices().isEmpty()) {
+        qCDebug(DISMAN_BACKEND_LAUNCHER) << "Last client left the bus.";
+        m_idle_timer->start();
+    }
+}
+
+void BackendLoader::handle_idle_timeout()
+{
+    if (!m_client_watcher->watchedServices().isEmpty()) {
+        m_idle_timer->start();
+        return;
+    }
+
+    // Every peer connects on the session bus first, this is only in case the bus went away.
+    prune_peer_connections();
+    if (!m_peer_connections.isEmpty()) {
+        m_idle_timer->start();
+        return;
+    }
+
+    qCDebug(DISMAN_BACKEND_LAUNCHER) << "Idle timeout reached. Quitting.";
+    save_snapshot();
+    m_keep_snapshot = true;
+    qApp->quit();
+}
+
+void BackendLoader::save_snapshot() const
+{
+    if (!m_worker) {
+        return;
+    }
+
+    auto const config = m_worker->current_config();
+    if (!config) {
+        return;
+    }
+
+    QJsonObject obj;
+    obj[QLatin1String("backend")] = m_worker->backend()->name();
+    obj[QLatin1String("arguments")] = QJsonObject::fromVariantMap(m_backend_arguments);
+    obj[QLatin1String("config")] = Disman::ConfigSerializer::serialize_config(config);
+
+    QSaveFile file(snapshot_file_path());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(DISMAN_BACKEND_LAUNCHER) << "Failed to write snapshot:" << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+Disman::ConfigPtr BackendLoader::take_snapshot(QString const& backend,
+                                               QVariantMap const& arguments) const
+{
+    QFile file(snapshot_file_path());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    // A snapshot is used once, later starts would serve an outdated state.
+    auto const obj = QJsonDocument::fromJson(file.readAll()).object();
+    file.remove();
+
+    if (obj[QLatin1String("backend")].toString() != backend
+        || obj[QLatin1String("arguments")].toObject()
+            != QJsonObject::fromVariantMap(arguments)) {
+        return nullptr;
+    }
+
+    auto config = Disman::ConfigSerializer::deserialize_config(
+        obj[QLatin1String("config")].toObject());
+    if (config) {
+        qCDebug(DISMAN_BACKEND_LAUNCHER) << "Continuing from snapshot.";
+    }
+    return config;
+}
+
+QVariantMap BackendLoader::stats() const
+{
+    auto stats = Disman::Metrics::snapshot();
+    stats.insert(QStringLiteral("backend"), backend());
+    return stats;
+}
+
+QString BackendLoader::peerAddress() const
+{
+    if (!m_peer_server) {
+        return QString();
+    }
+    return m_peer_server->address();
+}
+
 void BackendLoader::quit()
 {
     qApp->quit();
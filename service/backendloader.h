@@ -19,15 +19,27 @@
 #ifndef BACKENDLAUNCHER_H
 #define BACKENDLAUNCHER_H
 
+#include <QDBusConnection>
 #include <QDBusContext>
+#include <QElapsedTimer>
 #include <QObject>
+#include <QStringList>
+
+#include "backendworker.h"
+#include "types.h"
+
+#include <vector>
 
 namespace Disman
 {
 class Backend;
 }
 
+class QDBusServer;
+class QDBusServiceWatcher;
 class QPluginLoader;
+class QThread;
+class QTimer;
 class BackendDBusWrapper;
 
 class BackendLoader : public QObject, protected QDBusContext
@@ -43,14 +55,59 @@ public:
 
     Q_INVOKABLE QString backend() const;
     Q_INVOKABLE bool requestBackend(const QString& name, const QVariantMap& arguments);
+    Q_INVOKABLE QString peerAddress() const;
     Q_INVOKABLE void quit();
 
+    Q_INVOKABLE QVariantMap stats() const;
+
 private:
     Disman::Backend* loadBackend(const QString& name, const QVariantMap& arguments);
+    bool setup_backend(Disman::Backend* backend);
+    void finish_backend_init();
+    void destroy_backend();
+
+    void record_start();
+    void record_stop();
+
+    void start_peer_server();
+    void handle_peer_connection(QDBusConnection connection);
+    void prune_peer_connections();
+    void export_backend_to_peers();
+
+    void start_idle_timer();
+    void track_client();
+    void handle_client_gone(QString const& service);
+    void handle_idle_timeout();
+    void save_snapshot() const;
+    Disman::ConfigPtr take_snapshot(QString const& backend, QVariantMap const& arguments) const;
 
 private:
     QPluginLoader* mLoader = nullptr;
+
+    // The D-Bus front of the backend lives on its own thread, the worker on the main thread.
     BackendDBusWrapper* mBackend = nullptr;
+    BackendWorker* m_worker{nullptr};
+    QThread* m_front_thread{nullptr};
+
+    // Set while a backend connects asynchronously to the windowing system. Backend requests are
+    // answered when it is done.
+    Disman::Backend* m_loading_backend{nullptr};
+    std::vector<PendingCall> m_pending_requests;
+    QElapsedTimer m_load_timer;
+
+    bool m_state_recorded{false};
+
+    QDBusServer* m_peer_server{nullptr};
+    QStringList m_peer_connections;
+
+    // Only set when an idle timeout is configured. Clients on the session bus that requested a
+    // backend are watched until they leave the bus.
+    QTimer* m_idle_timer{nullptr};
+    QDBusServiceWatcher* m_client_watcher{nullptr};
+
+    // The snapshot is kept as checkpoint for a restart after a crash or an idle timeout.
+    QVariantMap m_backend_arguments;
+    bool m_keep_snapshot{false};
 };
 
 #endif // BACKENDLAUNCHER_H
@@ -0,0 +1,354 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "backendworker.h"
+
+#include "backenddbuswrapper.h"
+#include "disman_backend_launcher_debug.h"
+
+#include "backend.h"
+#include "config.h"
+#include "metrics.h"
+#include "mode.h"
+#include "output.h"
+#include "trace.h"
+
+#include <QTimer>
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+
+constexpr size_t history_size{16};
+
+// Calls waiting for the windowing system to confirm their config are answered with the current
+// config after this time.
+constexpr std::chrono::seconds confirm_timeout{3};
+
+/// Config::compare without the cause, which tells why a config was created, not what it is.
+bool same_state(Disman::ConfigPtr const& config, Disman::ConfigPtr const& current)
+{
+    auto const cause = config->cause();
+    config->set_cause(current->cause());
+    auto const same = config->compare(current);
+    config->set_cause(cause);
+    return same;
+}
+
+template<typename Value, typename Arg>
+void take_change(Disman::OutputPtr const& request,
+                 Disman::OutputPtr const& base,
+                 Disman::OutputPtr const& current,
+                 Value (Disman::Output::*get)() const,
+                 void (Disman::Output::*set)(Arg))
+{
+    auto const value = ((*request).*get)();
+    if (value != ((*base).*get)()) {
+        ((*current).*set)(value);
+    }
+}
+
+std::string mode_id(Disman::OutputPtr const& output)
+{
+    auto const mode = output->commanded_mode();
+    return mode ? mode->id() : std::string();
+}
+
+}
+
+BackendWorker::BackendWorker(Disman::Backend* backend)
+    : QObject()
+    , m_backend{backend}
+    , m_confirm_timer{new QTimer(this)}
+{
+    m_confirm_timer->setSingleShot(true);
+    m_confirm_timer->setInterval(confirm_timeout);
+    connect(m_confirm_timer, &QTimer::timeout, this, &BackendWorker::confirm_timed_out);
+
+    connect(m_backend,
+            &Disman::Backend::config_changed,
+            this,
+            &BackendWorker::handle_backend_change);
+}
+
+template<typename Function>
+void BackendWorker::post(Function&& function)
+{
+    if (m_front) {
+        QMetaObject::invokeMethod(m_front, std::forward<Function>(function), Qt::QueuedConnection);
+    }
+}
+
+Disman::Backend* BackendWorker::backend() const
+{
+    return m_backend;
+}
+
+void BackendWorker::set_front(BackendDBusWrapper* front)
+{
+    m_front = front;
+}
+
+void BackendWorker::start(Disman::ConfigPtr const& snapshot)
+{
+    if (!snapshot) {
+        return;
+    }
+
+    qCDebug(DISMAN_BACKEND_LAUNCHER) << "Serving config from snapshot.";
+    m_snapshot_pending = true;
+
+    auto const published = update(snapshot);
+    post([front = m_front, published] { front->publish(published, 0); });
+    QTimer::singleShot(0, this, &BackendWorker::revalidate_snapshot);
+}
+
+Disman::ConfigPtr BackendWorker::current_config() const
+{
+    return m_config;
+}
+
+void BackendWorker::request_config()
+{
+    auto config = m_config;
+    if (!config) {
+        config = m_backend->config();
+    }
+
+    Disman::ConfigSnapshot published;
+    if (config) {
+        published = update(config);
+    } else {
+        qCWarning(DISMAN_BACKEND_LAUNCHER) << "Backend provided an empty config!";
+    }
+
+    post([front = m_front, published, trace_id = Disman::Trace::current_id()] {
+        front->publish(published, trace_id);
+    });
+}
+
+void BackendWorker::apply(Disman::ConfigSnapshot const& snapshot,
+                          PendingCall const& call,
+                          uint64_t trace_id)
+{
+    Disman::Trace::set_current_id(trace_id);
+
+    // The backend decides from here on, a snapshot not yet compared is of no use anymore.
+    m_snapshot_pending = false;
+
+    auto config = snapshot.to_config();
+
+    if (m_config) {
+        // A config based on an older generation only carries the changes the client made to that
+        // one. These are moved onto the current config, so concurrent clients do not revert each
+        // other's changes.
+        auto const base = config->generation();
+        if (base != 0 && base != m_generation) {
+            auto rebased = rebase(config);
+            if (!rebased) {
+                qCDebug(DISMAN_BACKEND_LAUNCHER)
+                    << "Rejecting config based on generation" << base << "while at"
+                    << m_generation;
+                call.connection.send(call.message.createErrorReply(
+                    QStringLiteral("org.kwinft.disman.Error.StaleConfig"),
+                    QStringLiteral("Config is based on generation %1 that can not be rebased, "
+                                   "current generation is %2")
+                        .arg(base)
+                        .arg(m_generation)));
+                return;
+            }
+            qCDebug(DISMAN_BACKEND_LAUNCHER)
+                << "Rebased config from generation" << base << "to" << m_generation;
+            config = rebased;
+        }
+
+        if (same_state(config, m_config)) {
+            qCDebug(DISMAN_BACKEND_LAUNCHER) << "Requested config is current. Skip applying it.";
+            post([front = m_front, call] { front->reply(call); });
+            return;
+        }
+    }
+
+    // The backend may emit the committed config already while applying. Then the call is
+    // answered with it from handle_backend_change.
+    auto const waiting = m_unconfirmed.size();
+    m_unconfirmed.push_back(call);
+
+    Disman::ConfigPtr committed;
+    {
+        Disman::Metrics::Timer timer(QStringLiteral("apply-duration.")
+                                     + m_backend->name().toLower());
+        committed = m_backend->set_config(config);
+    }
+
+    if (m_unconfirmed.size() != waiting + 1) {
+        return;
+    }
+    if (!committed) {
+        qCDebug(DISMAN_BACKEND_LAUNCHER) << "Waiting for the windowing system to confirm config.";
+        m_confirm_timer->start();
+        return;
+    }
+
+    m_unconfirmed.pop_back();
+    auto const published = update(committed);
+    post([front = m_front, published, trace_id, call] {
+        front->publish_applied(published, trace_id, {call});
+    });
+}
+
+void BackendWorker::handle_backend_change(Disman::ConfigPtr const& config)
+{
+    assert(config != nullptr);
+    if (!config) {
+        qCWarning(DISMAN_BACKEND_LAUNCHER) << "Backend provided an empty config!";
+        return;
+    }
+
+    m_snapshot_pending = false;
+
+    auto const published = update(config);
+    auto const trace_id = Disman::Trace::current_id();
+
+    if (m_unconfirmed.empty()) {
+        post([front = m_front, published, trace_id] {
+            front->publish_change(published, trace_id);
+        });
+        return;
+    }
+
+    // The windowing system confirmed the applied config, possibly with own changes.
+    m_confirm_timer->stop();
+    post([front = m_front, published, trace_id, calls = std::move(m_unconfirmed)] {
+        front->publish_applied(published, trace_id, calls);
+    });
+    m_unconfirmed.clear();
+}
+
+void BackendWorker::confirm_timed_out()
+{
+    if (m_unconfirmed.empty()) {
+        return;
+    }
+
+    qCWarning(DISMAN_BACKEND_LAUNCHER)
+        << "Windowing system did not confirm config. Answering with the current one.";
+    post([front = m_front, calls = std::move(m_unconfirmed)] {
+        for (auto const& call : calls) {
+            front->reply(call);
+        }
+    });
+    m_unconfirmed.clear();
+}
+
+void BackendWorker::revalidate_snapshot()
+{
+    if (!m_snapshot_pending) {
+        return;
+    }
+    m_snapshot_pending = false;
+
+    auto const config = m_backend->config();
+    if (!config || same_state(config, m_config)) {
+        return;
+    }
+
+    qCDebug(DISMAN_BACKEND_LAUNCHER) << "Snapshot outdated. Publishing current config.";
+    handle_backend_change(config);
+}
+
+Disman::ConfigPtr BackendWorker::rebase(Disman::ConfigPtr const& request) const
+{
+    auto const it = std::find_if(m_history.cbegin(), m_history.cend(), [&](auto const& snapshot) {
+        return snapshot.generation() == request->generation();
+    });
+    if (it == m_history.cend()) {
+        return nullptr;
+    }
+
+    auto const base = it->to_config();
+    if (request->hash() != base->hash() || m_config->hash() != base->hash()) {
+        return nullptr;
+    }
+
+    auto rebased = m_config->clone();
+    rebased->set_cause(request->cause());
+
+    for (auto const& [id, output] : request->outputs()) {
+        auto const base_output = base->output(id);
+        auto const current = rebased->output(id);
+        if (!base_output || !current) {
+            return nullptr;
+        }
+
+        using Disman::Output;
+        take_change(output, base_output, current, &Output::enabled, &Output::set_enabled);
+        take_change(output, base_output, current, &Output::position, &Output::set_position);
+        take_change(output, base_output, current, &Output::rotation, &Output::set_rotation);
+        take_change(output, base_output, current, &Output::scale, &Output::set_scale);
+        take_change(
+            output, base_output, current, &Output::adaptive_sync, &Output::set_adaptive_sync);
+        take_change(output,
+                    base_output,
+                    current,
+                    &Output::replication_source,
+                    &Output::set_replication_source);
+        take_change(output,
+                    base_output,
+                    current,
+                    &Output::follow_preferred_mode,
+                    &Output::set_follow_preferred_mode);
+        take_change(
+            output, base_output, current, &Output::auto_resolution, &Output::set_auto_resolution);
+        take_change(output,
+                    base_output,
+                    current,
+                    &Output::auto_refresh_rate,
+                    &Output::set_auto_refresh_rate);
+        take_change(output, base_output, current, &Output::auto_rotate, &Output::set_auto_rotate);
+        take_change(output,
+                    base_output,
+                    current,
+                    &Output::auto_rotate_only_in_tablet_mode,
+                    &Output::set_auto_rotate_only_in_tablet_mode);
+        take_change(output, base_output, current, &Output::retention, &Output::set_retention);
+
+        if (auto const requested = mode_id(output); requested != mode_id(base_output)) {
+            if (auto const mode = current->mode(requested)) {
+                current->set_mode(mode);
+            }
+        }
+    }
+
+    auto const primary = request->primary_output();
+    auto const base_primary = base->primary_output();
+    if ((primary ? primary->id() : 0) != (base_primary ? base_primary->id() : 0)) {
+        rebased->set_primary_output(primary ? rebased->output(primary->id()) : nullptr);
+    }
+
+    return rebased;
+}
+
+Disman::ConfigSnapshot BackendWorker::update(Disman::ConfigPtr const& config)
+{
+    if (!m_config || !same_state(config, m_config)) {
+        m_generation++;
+    }
+    config->set_generation(m_generation);
+    m_config = config;
+
+    Disman::ConfigSnapshot snapshot(config);
+    if (!m_history.empty() && m_history.back().generation() == m_generation) {
+        m_history.back() = snapshot;
+    } else {
+        m_history.push_back(snapshot);
+        if (m_history.size() > history_size) {
+            m_history.pop_front();
+        }
+    }
+    return snapshot;
+}
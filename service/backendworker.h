@@ -0,0 +1,101 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include "configsnapshot.h"
+#include "types.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QObject>
+
+#include <deque>
+#include <vector>
+
+namespace Disman
+{
+class Backend;
+}
+
+class BackendDBusWrapper;
+class QTimer;
+
+/// A D-Bus call that is answered once the request it carries was handled.
+struct PendingCall {
+    QDBusConnection connection;
+    QDBusMessage message;
+};
+
+/**
+ * Drives the backend on the main thread, where the windowing system connections of the backends
+ * live. It applies the configs requested through the D-Bus front and follows the changes of the
+ * backend. Each resulting config is published to the front as snapshot.
+ *
+ * Front and worker only talk through the event queue of the receiving thread. Requests are
+ * handled and publications received in the order they were sent.
+ */
+class BackendWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BackendWorker(Disman::Backend* backend);
+
+    Disman::Backend* backend() const;
+
+    /// Must be reset before the front is destroyed.
+    void set_front(BackendDBusWrapper* front);
+
+    /**
+     * Publishes @p snapshot right away. The config of the backend is compared afterwards and
+     * published as change when it differs.
+     */
+    void start(Disman::ConfigPtr const& snapshot);
+
+    /// The config published last.
+    Disman::ConfigPtr current_config() const;
+
+    /// Publishes the current config. A null snapshot is published if the backend has none.
+    void request_config();
+
+    /**
+     * Applies @p config and answers @p call with the committed config. When the windowing system
+     * applies it asynchronously the answer waits for the config it confirms.
+     */
+    void apply(Disman::ConfigSnapshot const& config, PendingCall const& call, uint64_t trace_id);
+
+private:
+    void handle_backend_change(Disman::ConfigPtr const& config);
+    void revalidate_snapshot();
+    void confirm_timed_out();
+
+    /**
+     * Takes over the changes @p request made to the published config it is based on onto the
+     * current config. Null if that config is not known anymore or had other outputs.
+     */
+    Disman::ConfigPtr rebase(Disman::ConfigPtr const& request) const;
+
+    /// Sets the generation of @p config and makes it the current one.
+    Disman::ConfigSnapshot update(Disman::ConfigPtr const& config);
+
+    template<typename Function>
+    void post(Function&& function);
+
+    Disman::Backend* m_backend;
+    BackendDBusWrapper* m_front{nullptr};
+
+    Disman::ConfigPtr m_config;
+    uint64_t m_generation{0};
+
+    // The configs published last, oldest first. Requests based on these can be rebased.
+    std::deque<Disman::ConfigSnapshot> m_history;
+
+    bool m_snapshot_pending{false};
+
+    // Calls answered once the backend emits the config the windowing system confirmed.
+    std::vector<PendingCall> m_unconfirmed;
+    QTimer* m_confirm_timer;
+};
@@ -21,13 +21,26 @@
 #include <QSessionManager>
 
 #include "backendloader.h"
+#include "backendmanager_p.h"
 #include "disman_backend_launcher_debug.h"
 #include "log.h"
 
 #include <memory>
 
+/// D-Bus activation of a named instance passes the name as argument instead of in the environment.
+static void read_instance_argument(int argc, char** argv)
+{
+    for (int i = 1; i + 1 < argc; i++) {
+        if (qstrcmp(argv[i], "--instance") == 0) {
+            qputenv("DISMAN_INSTANCE", argv[i + 1]);
+            return;
+        }
+    }
+}
+
 int main(int argc, char** argv)
 {
+    read_instance_argument(argc, argv);
     Disman::Log::instance();
     QGuiApplication::setDesktopSettingsAware(false);
     QGuiApplication app(argc, argv);
@@ -37,9 +50,10 @@ int main(int argc, char** argv)
     QObject::connect(&app, &QGuiApplication::commitDataRequest, disableSessionManagement);
     QObject::connect(&app, &QGuiApplication::saveStateRequest, disableSessionManagement);
 
-    if (!QDBusConnection::sessionBus().registerService(QStringLiteral("org.kwinft.disman"))) {
+    auto const service = Disman::BackendManager::service_name();
+    if (!QDBusConnection::sessionBus().registerService(service)) {
         qCWarning(DISMAN_BACKEND_LAUNCHER)
-            << "Cannot register Disman service. Another launcher already running?";
+            << "Cannot register Disman service" << service << "- another launcher already running?";
         return -1;
     }
 
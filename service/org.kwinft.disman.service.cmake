@@ -1,3 +1,3 @@
 [D-BUS Service]
-Name=org.kwinft.disman
-Exec=@CMAKE_INSTALL_FULL_LIBEXECDIR@/disman-launcher
+Name=@DISMAN_SERVICE_NAME@
+Exec=@CMAKE_INSTALL_FULL_LIBEXECDIR@/disman-launcher@DISMAN_LAUNCHER_ARGS@
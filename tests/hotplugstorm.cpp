@@ -0,0 +1,393 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "hotplugstorm.h"
+
+#include "backendmanager_p.h"
+#include "config.h"
+#include "configmonitor.h"
+#include "getconfigoperation.h"
+#include "output.h"
+
+#include "fakebackendinterface.h"
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QFile>
+#include <QProcess>
+#include <QTimer>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace Disman
+{
+
+namespace
+{
+
+int64_t now_ns()
+{
+    // The steady clock is CLOCK_MONOTONIC on Linux and therefore comparable between processes.
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+QString signature(ConfigPtr const& config)
+{
+    QStringList ids;
+    for (auto const& [id, output] : config->outputs()) {
+        ids << QString::number(id);
+    }
+    return ids.join(QLatin1Char(','));
+}
+
+/// User plus system time of a process in clock ticks or -1 if unknown.
+int64_t process_ticks(uint pid)
+{
+    QFile file(QStringLiteral("/proc/%1/stat").arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    // The command name can contain spaces. Fields are counted from its closing parenthesis.
+    auto const stat = file.readAll();
+    auto const fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 13) {
+        return -1;
+    }
+    // utime and stime are fields 14 and 15 of the whole line.
+    return fields.at(11).toLongLong() + fields.at(12).toLongLong();
+}
+
+double rusage_ms(rusage const& usage)
+{
+    auto to_ms = [](timeval const& tv) { return tv.tv_sec * 1000. + tv.tv_usec / 1000.; };
+    return to_ms(usage.ru_utime) + to_ms(usage.ru_stime);
+}
+
+void print_histogram(std::vector<double> latencies_ms)
+{
+    if (latencies_ms.empty()) {
+        std::cout << "  no latencies recorded" << std::endl;
+        return;
+    }
+
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    auto percentile = [&latencies_ms](double p) {
+        auto const index = static_cast<size_t>(p * (latencies_ms.size() - 1) + 0.5);
+        return latencies_ms.at(index);
+    };
+
+    printf("  samples %zu  p50 %.2f ms  p90 %.2f ms  p99 %.2f ms  max %.2f ms\n",
+           latencies_ms.size(),
+           percentile(0.5),
+           percentile(0.9),
+           percentile(0.99),
+           latencies_ms.back());
+
+    // Buckets with power-of-two upper bounds in milliseconds.
+    std::vector<size_t> buckets;
+    for (auto latency : latencies_ms) {
+        size_t bucket = 0;
+        while ((1 << bucket) < latency) {
+            bucket++;
+        }
+        if (buckets.size() <= bucket) {
+            buckets.resize(bucket + 1, 0);
+        }
+        buckets[bucket]++;
+    }
+
+    auto const max_count = *std::max_element(buckets.cbegin(), buckets.cend());
+    for (size_t i = 0; i < buckets.size(); i++) {
+        auto const bar = std::string(buckets[i] * 50 / max_count, '#');
+        printf("  <= %6d ms %8zu %s\n", 1 << i, buckets[i], bar.c_str());
+    }
+}
+
+}
+
+HotplugStorm::HotplugStorm(Options const& options, QObject* parent)
+    : QObject(parent)
+    , m_options{options}
+{
+}
+
+HotplugStorm::~HotplugStorm()
+{
+    for (auto& client : m_clients) {
+        if (client.process->state() != QProcess::NotRunning) {
+            client.process->kill();
+            client.process->waitForFinished();
+        }
+    }
+}
+
+int HotplugStorm::run_client()
+{
+    auto op = new GetConfigOperation;
+    if (!op->exec()) {
+        std::cerr << "Client failed to get config: " << qPrintable(op->error_string()) << std::endl;
+        return 1;
+    }
+
+    auto config = op->config();
+    auto monitor = ConfigMonitor::instance();
+    monitor->add_config(config);
+
+    QObject::connect(monitor, &ConfigMonitor::configuration_changed, monitor, [config] {
+        std::cout << now_ns() << ' ' << qPrintable(signature(config)) << std::endl;
+    });
+
+    std::cout << "ready" << std::endl;
+    return qApp->exec();
+}
+
+void HotplugStorm::start()
+{
+    // Start the service and backend before the clients so they do not compete for doing that.
+    auto op = new GetConfigOperation;
+    if (!op->exec()) {
+        std::cerr << "Failed to get initial config: " << qPrintable(op->error_string())
+                  << std::endl;
+        qApp->exit(1);
+        return;
+    }
+    for (auto const& [id, output] : op->config()->outputs()) {
+        m_outputs.push_back(id);
+    }
+
+    m_fake = new OrgKwinftDismanFakebackendInterface(Disman::BackendManager::service_name(),
+                                                     QStringLiteral("/fake"),
+                                                     QDBusConnection::sessionBus(),
+                                                     this);
+    if (!m_fake->isValid()) {
+        std::cerr << "Fake backend not available. Is the fake backend plugin installed?"
+                  << std::endl;
+        qApp->exit(1);
+        return;
+    }
+
+    create_steps();
+    spawn_clients();
+}
+
+void HotplugStorm::spawn_clients()
+{
+    m_clients.resize(m_options.clients);
+
+    for (size_t i = 0; i < m_clients.size(); i++) {
+        auto process = new QProcess(this);
+        m_clients[i].process = process;
+
+        process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        connect(process, &QProcess::readyReadStandardOutput, this, [this, i] {
+            auto& client = m_clients[i];
+            read_client(client);
+
+            if (!client.ready) {
+                return;
+            }
+            auto const all_ready = std::all_of(
+                m_clients.cbegin(), m_clients.cend(), [](auto const& cl) { return cl.ready; });
+            if (all_ready && m_events.empty() && !m_start_ns) {
+                std::cout << "All " << m_clients.size() << " clients ready. Running scenario '"
+                          << qPrintable(m_options.scenario) << "' with " << m_steps.size()
+                          << " events." << std::endl;
+
+                auto const pid = QDBusConnection::sessionBus().interface()->servicePid(
+                    Disman::BackendManager::service_name());
+                m_service_ticks_start = process_ticks(pid);
+                m_start_ns = now_ns();
+                run_step(0);
+            }
+        });
+
+        process->start(QCoreApplication::applicationFilePath(), {QStringLiteral("--client")});
+    }
+}
+
+void HotplugStorm::read_client(Client& client)
+{
+    client.buffer += client.process->readAllStandardOutput();
+
+    int end;
+    while ((end = client.buffer.indexOf('\n')) >= 0) {
+        auto const line = client.buffer.left(end);
+        client.buffer.remove(0, end + 1);
+
+        if (line == "ready") {
+            client.ready = true;
+            continue;
+        }
+
+        auto const space = line.indexOf(' ');
+        client.observations.push_back(
+            {line.left(space).toLongLong(), QString::fromLatin1(line.mid(space + 1))});
+    }
+}
+
+void HotplugStorm::create_steps()
+{
+    auto const interval = m_options.interval_ms;
+    int next_id = 100;
+
+    if (m_options.scenario == QLatin1String("dock")) {
+        // Docking station with three displays being plugged in and out.
+        for (int i = 0; i < m_options.iterations; i++) {
+            for (int j = 0; j < 3; j++) {
+                m_steps.push_back({j == 0 ? interval : 0, true, next_id + j});
+            }
+            for (int j = 0; j < 3; j++) {
+                m_steps.push_back({j == 0 ? interval : 0, false, next_id + j});
+            }
+        }
+    } else if (m_options.scenario == QLatin1String("flap")) {
+        // A DisplayPort link going up and down faster than the service collects changes.
+        auto const flap_interval = std::max(1, interval / 20);
+        for (int i = 0; i < m_options.iterations * 10; i++) {
+            m_steps.push_back({flap_interval, true, next_id});
+            m_steps.push_back({flap_interval, false, next_id});
+        }
+    } else {
+        // Many outputs added one after the other and then removed again.
+        for (int i = 0; i < m_options.iterations; i++) {
+            for (int j = 0; j < 32; j++) {
+                m_steps.push_back({interval, true, next_id + j});
+            }
+            for (int j = 0; j < 32; j++) {
+                m_steps.push_back({interval, false, next_id + j});
+            }
+        }
+    }
+}
+
+void HotplugStorm::run_step(size_t index)
+{
+    if (index >= m_steps.size()) {
+        QTimer::singleShot(m_options.settle_ms, this, &HotplugStorm::finish);
+        return;
+    }
+
+    auto const& step = m_steps.at(index);
+
+    QTimer::singleShot(step.delay_ms, this, [this, index, step] {
+        auto const inject_ns = now_ns();
+
+        if (step.add) {
+            m_fake->addOutput(step.output_id, QStringLiteral("DP-%1").arg(step.output_id))
+                .waitForFinished();
+            m_outputs.push_back(step.output_id);
+            std::sort(m_outputs.begin(), m_outputs.end());
+        } else {
+            m_fake->removeOutput(step.output_id).waitForFinished();
+            m_outputs.erase(std::remove(m_outputs.begin(), m_outputs.end(), step.output_id),
+                            m_outputs.end());
+        }
+
+        m_events.push_back({inject_ns, model_signature()});
+        run_step(index + 1);
+    });
+}
+
+QString HotplugStorm::model_signature() const
+{
+    QStringList ids;
+    for (auto id : m_outputs) {
+        ids << QString::number(id);
+    }
+    return ids.join(QLatin1Char(','));
+}
+
+void HotplugStorm::finish()
+{
+    auto const pid = QDBusConnection::sessionBus().interface()->servicePid(
+        Disman::BackendManager::service_name());
+    m_service_ticks_end = process_ticks(pid);
+    m_end_ns = now_ns();
+
+    for (auto& client : m_clients) {
+        read_client(client);
+        client.process->terminate();
+        client.process->waitForFinished();
+    }
+
+    report();
+    qApp->quit();
+}
+
+void HotplugStorm::report()
+{
+    std::vector<double> latencies_ms;
+    size_t lost = 0;
+
+    // An event counts as delivered when a client sees its state or the state of any later event,
+    // since the service may fold several events into one change notification.
+    for (auto const& client : m_clients) {
+        auto const& obs = client.observations;
+
+        std::vector<int64_t> seen_ns(m_events.size(), -1);
+        for (size_t j = 0; j < m_events.size(); j++) {
+            auto const& event = m_events.at(j);
+            auto it = std::find_if(obs.cbegin(), obs.cend(), [&event](auto const& ob) {
+                return ob.time_ns >= event.inject_ns && ob.signature == event.expected;
+            });
+            if (it != obs.cend()) {
+                seen_ns[j] = it->time_ns;
+            }
+        }
+
+        int64_t best = -1;
+        for (size_t k = m_events.size(); k-- > 0;) {
+            if (seen_ns[k] >= 0 && (best < 0 || seen_ns[k] < best)) {
+                best = seen_ns[k];
+            }
+            if (best < 0) {
+                lost++;
+                continue;
+            }
+            latencies_ms.push_back((best - m_events.at(k).inject_ns) / 1000000.);
+        }
+    }
+
+    size_t notifications = 0;
+    for (auto const& client : m_clients) {
+        notifications += client.observations.size();
+    }
+
+    std::cout << std::endl
+              << "Events injected: " << m_events.size() << ", clients: " << m_clients.size()
+              << ", notifications received: " << notifications << ", events never seen: " << lost
+              << std::endl;
+    std::cout << "Latency from event to client notification:" << std::endl;
+    print_histogram(latencies_ms);
+
+    auto const wall_ms = (m_end_ns - m_start_ns) / 1000000.;
+    std::cout << std::endl << "CPU time during " << wall_ms << " ms:" << std::endl;
+
+    if (m_service_ticks_start >= 0 && m_service_ticks_end >= 0) {
+        auto const tick_ms = 1000. / sysconf(_SC_CLK_TCK);
+        std::cout << "  service  " << (m_service_ticks_end - m_service_ticks_start) * tick_ms
+                  << " ms" << std::endl;
+    } else {
+        std::cout << "  service  unknown" << std::endl;
+    }
+
+    rusage usage;
+    getrusage(RUSAGE_CHILDREN, &usage);
+    std::cout << "  clients  " << rusage_ms(usage) << " ms" << std::endl;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "  injector " << rusage_ms(usage) << " ms" << std::endl;
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+#include <cstdint>
+#include <vector>
+
+class OrgKwinftDismanFakebackendInterface;
+class QProcess;
+
+namespace Disman
+{
+
+/**
+ * Drives the fake backend with bursts of output changes and measures how long it takes until
+ * client processes are notified through the ConfigMonitor.
+ */
+class HotplugStorm : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options {
+        QString scenario;
+        int clients;
+        int iterations;
+        int interval_ms;
+        int settle_ms;
+    };
+
+    explicit HotplugStorm(Options const& options, QObject* parent = nullptr);
+    ~HotplugStorm() override;
+
+    void start();
+
+    /// Runs in the spawned client processes.
+    static int run_client();
+
+private:
+    struct Step {
+        int delay_ms;
+        bool add;
+        int output_id;
+    };
+
+    struct Event {
+        int64_t inject_ns;
+        QString expected;
+    };
+
+    struct Observation {
+        int64_t time_ns;
+        QString signature;
+    };
+
+    struct Client {
+        QProcess* process;
+        QByteArray buffer;
+        bool ready{false};
+        std::vector<Observation> observations;
+    };
+
+    void spawn_clients();
+    void read_client(Client& client);
+    void create_steps();
+    void run_step(size_t index);
+    void finish();
+    void report();
+
+    QString model_signature() const;
+
+    Options m_options;
+    OrgKwinftDismanFakebackendInterface* m_fake{nullptr};
+
+    std::vector<Client> m_clients;
+    std::vector<Step> m_steps;
+    std::vector<Event> m_events;
+    std::vector<int> m_outputs;
+
+    int64_t m_service_ticks_start{0};
+    int64_t m_service_ticks_end{0};
+    int64_t m_start_ns{0};
+    int64_t m_end_ns{0};
+};
+
+}
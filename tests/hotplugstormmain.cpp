@@ -0,0 +1,94 @@
+/*
+    SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only
+*/
+#include "hotplugstorm.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QProcess>
+#include <QTimer>
+
+#include <algorithm>
+#include <iostream>
+
+using namespace Disman;
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineOption scenario(
+        QStringList() << QStringLiteral("s") << QStringLiteral("scenario"),
+        QStringLiteral("Hotplug pattern to inject: dock, flap or many (default: dock)"),
+        QStringLiteral("name"),
+        QStringLiteral("dock"));
+    QCommandLineOption clients(QStringList() << QStringLiteral("c") << QStringLiteral("clients"),
+                               QStringLiteral("Number of client processes (default: 8)"),
+                               QStringLiteral("count"),
+                               QStringLiteral("8"));
+    QCommandLineOption iterations(QStringList()
+                                      << QStringLiteral("n") << QStringLiteral("iterations"),
+                                  QStringLiteral("Repetitions of the pattern (default: 20)"),
+                                  QStringLiteral("count"),
+                                  QStringLiteral("20"));
+    QCommandLineOption interval(
+        QStringList() << QStringLiteral("i") << QStringLiteral("interval"),
+        QStringLiteral("Milliseconds between hotplug bursts (default: 100)"),
+        QStringLiteral("ms"),
+        QStringLiteral("100"));
+    QCommandLineOption settle(
+        QStringLiteral("settle"),
+        QStringLiteral("Milliseconds to wait for notifications after the last event (default: 2000)"),
+        QStringLiteral("ms"),
+        QStringLiteral("2000"));
+    QCommandLineOption private_bus(
+        QStringLiteral("private-bus"),
+        QStringLiteral("Run everything on a private session bus started with dbus-run-session"));
+    QCommandLineOption client(QStringLiteral("client"),
+                              QStringLiteral("Internal: run as a monitoring client"));
+    client.setFlags(QCommandLineOption::HiddenFromHelp);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Injects output hotplug events into the fake backend and measures the "
+                       "latency until clients are notified."));
+    parser.addHelpOption();
+    parser.addOptions({scenario, clients, iterations, interval, settle, private_bus, client});
+    parser.process(app);
+
+    if (parser.isSet(client)) {
+        return HotplugStorm::run_client();
+    }
+
+    if (parser.isSet(private_bus)) {
+        // Do not disturb a running service and get reproducible results by using an own bus.
+        auto args = app.arguments();
+        args.removeAll(QStringLiteral("--private-bus"));
+        args.prepend(QStringLiteral("--"));
+        return QProcess::execute(QStringLiteral("dbus-run-session"), args);
+    }
+
+    auto const name = parser.value(scenario);
+    if (name != QLatin1String("dock") && name != QLatin1String("flap")
+        && name != QLatin1String("many")) {
+        std::cerr << "Unknown scenario: " << qPrintable(name) << std::endl;
+        return 1;
+    }
+
+    qputenv("DISMAN_BACKEND", "fake");
+    qputenv("DISMAN_BACKEND_ARGS", "TEST_DATA=" TEST_DATA "singleoutput.json");
+    qputenv("DISMAN_LOGGING", "false");
+
+    HotplugStorm::Options options;
+    options.scenario = name;
+    options.clients = std::max(1, parser.value(clients).toInt());
+    options.iterations = std::max(1, parser.value(iterations).toInt());
+    options.interval_ms = std::max(0, parser.value(interval).toInt());
+    options.settle_ms = std::max(0, parser.value(settle).toInt());
+
+    HotplugStorm storm(options);
+    QTimer::singleShot(0, &storm, &HotplugStorm::start);
+    return app.exec();
+}